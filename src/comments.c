@@ -148,7 +148,7 @@ comments_process_update_result (const struct updateResult * const result, gpoint
 				itemPtr comment = (itemPtr) iter->data;
 				comment->isComment = TRUE;
 				comment->parentItemId = commentFeed->itemId;
-				comment->parentNodeId = g_strdup (item->nodeId);
+				comment->parentNodeId = item->nodeId;
 				iter = g_list_next (iter);
 			}
 			
@@ -37,6 +37,11 @@
 #include <ctype.h>
 
 #include "common.h"
+
+#ifdef COMMON_STRCASESTR_X86
+#include <immintrin.h>
+#endif
+
 #include "debug.h"
 
 static gboolean pathsChecked = FALSE;
@@ -73,6 +78,7 @@ common_init_paths (void)
 	common_check_dir (g_strdup (lifereaCachePath));
 	common_check_dir (g_build_filename (lifereaCachePath, "feeds", NULL));
 	common_check_dir (g_build_filename (lifereaCachePath, "favicons", NULL));
+	common_check_dir (g_build_filename (lifereaCachePath, "images", NULL));
 	common_check_dir (g_build_filename (lifereaCachePath, "plugins", NULL));
 
 	common_check_dir (g_build_filename (g_get_user_config_dir(), "liferea", NULL));
@@ -292,7 +298,7 @@ typedef unsigned chartype;
    Foundation, Inc.  It was taken from the GNU C Library, which is
    licenced under the GPL v2.1 or (at your option) newer version. */
 char *
-common_strcasestr (const char *phaystack, const char *pneedle)
+common_strcasestr_scalar (const char *phaystack, const char *pneedle)
 {
 	register const unsigned char *haystack, *needle;
 	register chartype b, c;
@@ -370,6 +376,172 @@ common_strcasestr (const char *phaystack, const char *pneedle)
 	return 0;
 }
 
+#ifdef COMMON_STRCASESTR_X86
+
+/* Compares the needle with the start of the haystack ignoring case */
+static inline gboolean
+common_strcaseprefix (const guchar *haystack, const guchar *needle)
+{
+	for (; *needle; haystack++, needle++) {
+		if (tolower (*haystack) != tolower (*needle))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Both vector scans check a block of bytes at once for candidates
+   matching the first two needle characters in both cases and verify
+   only those. All loads are aligned to the block size, so they never
+   cross a page boundary and never touch memory beyond the page
+   holding the terminating zero. Folding with 0x20 maps exactly the
+   two cases of a letter onto the lower case letter, all other bytes
+   must match. The reads past the terminating zero are invisible to
+   AddressSanitizer this way. */
+
+char * __attribute__ ((target ("sse2"), no_sanitize_address))
+common_strcasestr_sse2 (const char *phaystack, const char *pneedle)
+{
+	const guchar	*haystack = (const guchar *)phaystack;
+	const guchar	*needle = (const guchar *)pneedle;
+	guchar		first, fold, second, fold2;
+	__m128i		vfirst, vfold, vsecond, vfold2, vzero;
+
+	first = tolower (needle[0]);
+	fold = g_ascii_isalpha (first)?0x20:0x00;
+	second = tolower (needle[1]);
+	fold2 = g_ascii_isalpha (second)?0x20:0x00;
+
+	while ((guintptr)haystack & 15) {
+		if (!*haystack)
+			return NULL;
+		if (((*haystack | fold) == first) && common_strcaseprefix (haystack, needle))
+			return (char *)haystack;
+		haystack++;
+	}
+
+	vfirst = _mm_set1_epi8 ((char)first);
+	vfold = _mm_set1_epi8 ((char)fold);
+	vsecond = _mm_set1_epi8 ((char)second);
+	vfold2 = _mm_set1_epi8 ((char)fold2);
+	vzero = _mm_setzero_si128 ();
+
+	for (;; haystack += 16) {
+		__m128i	block = _mm_load_si128 ((const __m128i *)haystack);
+		guint	zeros = _mm_movemask_epi8 (_mm_cmpeq_epi8 (block, vzero));
+		guint	candidates = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_or_si128 (block, vfold), vfirst));
+
+		/* The second character must follow, the last byte of the
+		   block stays a candidate as its successor is not loaded. */
+		if (candidates && second)
+			candidates &= (_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_or_si128 (block, vfold2), vsecond)) >> 1) | 0x8000;
+
+		/* ignore everything after the end of the haystack */
+		if (zeros)
+			candidates &= (zeros & -zeros) - 1;
+
+		while (candidates) {
+			guint offset = __builtin_ctz (candidates);
+			if (common_strcaseprefix (haystack + offset, needle))
+				return (char *)(haystack + offset);
+			candidates &= candidates - 1;
+		}
+
+		if (zeros)
+			return NULL;
+	}
+}
+
+char * __attribute__ ((target ("avx2"), no_sanitize_address))
+common_strcasestr_avx2 (const char *phaystack, const char *pneedle)
+{
+	const guchar	*haystack = (const guchar *)phaystack;
+	const guchar	*needle = (const guchar *)pneedle;
+	guchar		first, fold, second, fold2;
+	__m256i		vfirst, vfold, vsecond, vfold2, vzero;
+
+	first = tolower (needle[0]);
+	fold = g_ascii_isalpha (first)?0x20:0x00;
+	second = tolower (needle[1]);
+	fold2 = g_ascii_isalpha (second)?0x20:0x00;
+
+	while ((guintptr)haystack & 31) {
+		if (!*haystack)
+			return NULL;
+		if (((*haystack | fold) == first) && common_strcaseprefix (haystack, needle))
+			return (char *)haystack;
+		haystack++;
+	}
+
+	vfirst = _mm256_set1_epi8 ((char)first);
+	vfold = _mm256_set1_epi8 ((char)fold);
+	vsecond = _mm256_set1_epi8 ((char)second);
+	vfold2 = _mm256_set1_epi8 ((char)fold2);
+	vzero = _mm256_setzero_si256 ();
+
+	for (;; haystack += 32) {
+		__m256i	block = _mm256_load_si256 ((const __m256i *)haystack);
+		guint32	zeros = (guint32)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block, vzero));
+		guint32	candidates = (guint32)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_or_si256 (block, vfold), vfirst));
+
+		if (candidates && second)
+			candidates &= ((guint32)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_or_si256 (block, vfold2), vsecond)) >> 1) | 0x80000000;
+
+		if (zeros)
+			candidates &= (zeros & -zeros) - 1;
+
+		while (candidates) {
+			guint offset = __builtin_ctz (candidates);
+			if (common_strcaseprefix (haystack + offset, needle))
+				return (char *)(haystack + offset);
+			candidates &= candidates - 1;
+		}
+
+		if (zeros)
+			return NULL;
+	}
+}
+
+static inline gboolean
+common_strcasestr_ascii (char c)
+{
+	return !((guchar)c & 0x80) && (tolower (c) == g_ascii_tolower (c));
+}
+
+typedef char * (*strcasestrFunc) (const char *phaystack, const char *pneedle);
+
+/* Picks the widest vector scan the CPU supports */
+static strcasestrFunc
+common_strcasestr_get_vector_func (void)
+{
+	static strcasestrFunc	func = NULL;
+
+	if (!func) {
+		__builtin_cpu_init ();
+		if (__builtin_cpu_supports ("avx2"))
+			func = common_strcasestr_avx2;
+		else if (__builtin_cpu_supports ("sse2"))
+			func = common_strcasestr_sse2;
+		else
+			func = common_strcasestr_scalar;
+	}
+
+	return func;
+}
+
+#endif
+
+char *
+common_strcasestr (const char *phaystack, const char *pneedle)
+{
+#ifdef COMMON_STRCASESTR_X86
+	/* the vector scans only know about the case of ASCII letters */
+	if (*pneedle && common_strcasestr_ascii (pneedle[0]) && common_strcasestr_ascii (pneedle[1]))
+		return (common_strcasestr_get_vector_func ()) (phaystack, pneedle);
+#endif
+	return common_strcasestr_scalar (phaystack, pneedle);
+}
+
 gboolean
 common_str_is_empty (const gchar *s)
 {
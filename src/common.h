@@ -176,6 +176,21 @@ gchar *common_strreplace(gchar *string, const gchar *delimiter, const gchar *rep
  */
 char * common_strcasestr(const char *phaystack, const char *pneedle);
 
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define COMMON_STRCASESTR_X86 1
+#endif
+
+/* The implementations common_strcasestr() chooses from at runtime,
+   exported for the checks in tests/ only. The vector versions need
+   the respective CPU support and a needle starting with two ASCII
+   characters (the second can be the terminating zero). */
+char * common_strcasestr_scalar (const char *phaystack, const char *pneedle);
+#ifdef COMMON_STRCASESTR_X86
+char * common_strcasestr_sse2 (const char *phaystack, const char *pneedle);
+char * common_strcasestr_avx2 (const char *phaystack, const char *pneedle);
+#endif
+
 /**
  * Checks if a string is empty, when leading and trailing whitespace is ignored
  *
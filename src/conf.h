@@ -48,6 +48,7 @@
 #define DEFAULT_MAX_ITEMS		"maxitemcount"
 #define DEFAULT_UPDATE_INTERVAL		"default-update-interval"
 #define STARTUP_FEED_ACTION		"startup-feed-action"
+#define CACHE_IMAGES			"cache-images"
 
 /* folder handling settings */
 #define FOLDER_DISPLAY_MODE		"folder-display-mode"
@@ -32,12 +32,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#define _XOPEN_SOURCE	600 /* glibc2 needs this (man strptime) */
-
 #include "date.h"
 
-#include <locale.h>
-#include <ctype.h>
 #include <string.h>
 
 #include "common.h"
@@ -48,73 +44,81 @@
 
 /* date formatting methods */
 
+/* Item lists format the same dates over and over again. As the nice
+   format only depends on the minute of the date and the current day,
+   the formatted strings are cached per minute until the next midnight. */
+
+#define NICE_DATE_CACHE_SIZE	10000
+
+static GHashTable	*niceDateCache = NULL;	/**< minute -> formatted string */
+static time_t		niceDateDays[8];	/**< local midnight of tomorrow, today and the 6 days before */
+static gint		niceDateYear;		/**< current local year (as in struct tm) */
+
+static void
+date_format_nice_reset (time_t nowdate)
+{
+	struct tm	now, day;
+	gint		i;
+
+	if (!niceDateCache)
+		niceDateCache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	else
+		g_hash_table_remove_all (niceDateCache);
+
+	localtime_r (&nowdate, &now);
+	niceDateYear = now.tm_year;
+
+	for (i = 0; i < 8; i++) {
+		memset (&day, 0, sizeof (day));
+		day.tm_year = now.tm_year;
+		day.tm_mon = now.tm_mon;
+		day.tm_mday = now.tm_mday + 1 - i;	/* mktime() normalizes this */
+		day.tm_isdst = -1;
+		niceDateDays[i] = mktime (&day);
+	}
+}
+
 /* This function is originally from the Evolution 2.6.2 code (e-cell-date.c) */
 static gchar *
 date_format_nice (time_t date)
 {
 	time_t nowdate = time(NULL);
-	time_t yesdate;
-	struct tm then, now, yesterday;
+	struct tm then;
 	gchar *temp, *buf;
-	gboolean done = FALSE;
+	gint minute;
 	
 	if (date == 0) {
 		return g_strdup ("");
 	}
-	
+
+	/* Drop the cache at midnight (or when the clock was set back) */
+	if (!niceDateCache || nowdate >= niceDateDays[0] || nowdate < niceDateDays[1])
+		date_format_nice_reset (nowdate);
+
+	minute = (gint)((date >= 0)?(date / 60):((date - 59) / 60));
+	buf = g_hash_table_lookup (niceDateCache, GINT_TO_POINTER (minute));
+	if (buf)
+		return g_strdup (buf);
+
 	buf = g_new0(gchar, TIMESTRLEN + 1);
 
 	localtime_r (&date, &then);
-	localtime_r (&nowdate, &now);
 
-/*	if (nowdate - date < 60 * 60 * 8 && nowdate > date) {
-		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%l:%M %p"), &then);
-		done = TRUE;
-	}*/
-
-	if (!done) {
-		if (then.tm_mday == now.tm_mday &&
-		    then.tm_mon == now.tm_mon &&
-		    then.tm_year == now.tm_year) {
-		    	/* translation hint: date format for today, reorder format codes as necessary */
-			e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("Today %l:%M %p"), &then);
-			done = TRUE;
-		}
-	}
-	if (!done) {
-		yesdate = nowdate - 60 * 60 * 24;
-		localtime_r (&yesdate, &yesterday);
-		if (then.tm_mday == yesterday.tm_mday &&
-		    then.tm_mon == yesterday.tm_mon &&
-		    then.tm_year == yesterday.tm_year) {
-		    	/* translation hint: date format for yesterday, reorder format codes as necessary */
-			e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("Yesterday %l:%M %p"), &then);
-			done = TRUE;
-		}
-	}
-	if (!done) {
-		int i;
-		for (i = 2; i < 7; i++) {
-			yesdate = nowdate - 60 * 60 * 24 * i;
-			localtime_r (&yesdate, &yesterday);
-			if (then.tm_mday == yesterday.tm_mday &&
-			    then.tm_mon == yesterday.tm_mon &&
-			    then.tm_year == yesterday.tm_year) {
-			    	/* translation hint: date format for dates older than 2 days but not older than a week, reorder format codes as necessary */
-				e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%a %l:%M %p"), &then);
-				done = TRUE;
-				break;
-			}
-		}
-	}
-	if (!done) {
-		if (then.tm_year == now.tm_year) {
-			/* translation hint: date format for dates older than a week but from this year, reorder format codes as necessary */
-			e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%b %d %l:%M %p"), &then);
-		} else {
-			/* translation hint: date format for dates from the last years, reorder format codes as necessary */
-			e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%b %d %Y"), &then);
-		}
+	if (date >= niceDateDays[1] && date < niceDateDays[0]) {
+	    	/* translation hint: date format for today, reorder format codes as necessary */
+		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("Today %l:%M %p"), &then);
+	} else if (date >= niceDateDays[2] && date < niceDateDays[1]) {
+	    	/* translation hint: date format for yesterday, reorder format codes as necessary */
+		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("Yesterday %l:%M %p"), &then);
+	} else if (date >= niceDateDays[7] && date < niceDateDays[2]) {
+	    	/* translation hint: date format for dates older than 2 days but not older than a week, reorder format codes as necessary */
+		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%a %l:%M %p"), &then);
+	} else if (then.tm_year == niceDateYear) {
+		/* translation hint: date format for dates older than a week but from this year, reorder format codes as necessary */
+		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%b %d %l:%M %p"), &then);
+	} else {
+		/* translation hint: date format for dates from the last years, reorder format codes as necessary */
+		e_utf8_strftime_fix_am_pm (buf, TIMESTRLEN, _("%b %d %Y"), &then);
 	}
 
 	temp = buf;
@@ -122,6 +126,11 @@ date_format_nice (time_t date)
 		memmove (temp, temp + 1, strlen (temp));
 	}
 	temp = g_strstrip (buf);
+
+	if (g_hash_table_size (niceDateCache) >= NICE_DATE_CACHE_SIZE)
+		g_hash_table_remove_all (niceDateCache);
+	g_hash_table_insert (niceDateCache, GINT_TO_POINTER (minute), g_strdup (temp));
+
 	return temp;
 }
 
@@ -149,82 +158,148 @@ date_format (time_t date, const gchar *date_format)
 
 /* date parsing methods */
 
+/* The parsers below do not use strptime() and mktime(). They neither
+   depend on the locale nor on the local timezone and compute the UTC
+   timestamp directly from the broken down date. */
+
+/** @returns the number of days since 1970-01-01 of the given proleptic Gregorian date */
+static gint64
+date_days_from_civil (gint64 year, guint month, guint day)
+{
+	gint64	era, yoe, doy, doe;
+
+	/* count years from March, so the leap day is the last day of the year */
+	year -= (month <= 2);
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;						/* [0, 399] */
+	doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;	/* [0, 365] */
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;			/* [0, 146096] */
+
+	return era * 146097 + doe - 719468;
+}
+
+static time_t
+date_to_time (gint year, gint month, gint day, gint hour, gint minute, gint second)
+{
+	/* Days beyond the end of a month roll over into the next
+	   month just like mktime() normalized them before. */
+	return (time_t)(date_days_from_civil (year, month, day) * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+/**
+ * Parses an unsigned number of 1 to maxDigits digits.
+ *
+ * @returns position after the number or NULL if there is no digit
+ */
+static const gchar *
+date_parse_number (const gchar *pos, guint maxDigits, gint *result)
+{
+	guint	digits = 0;
+
+	*result = 0;
+	while (digits < maxDigits && g_ascii_isdigit (*pos)) {
+		*result = 10 * *result + (*pos++ - '0');
+		digits++;
+	}
+
+	return digits?pos:NULL;
+}
+
+static const gchar *
+date_skip_space (const gchar *pos)
+{
+	while (g_ascii_isspace (*pos))
+		pos++;
+
+	return pos;
+}
+
+/**
+ * Parses a numeric timezone offset like "+hh", "+hhmm" or "+hh:mm".
+ *
+ * @returns position after the offset or NULL if there is no offset
+ */
+static const gchar *
+date_parse_numeric_tz (const gchar *pos, time_t *offset)
+{
+	gint	hours, minutes = 0;
+
+	if (*pos != '+' && *pos != '-')
+		return NULL;
+	if (!g_ascii_isdigit (pos[1]) || !g_ascii_isdigit (pos[2]))
+		return NULL;
+
+	hours = 10 * (pos[1] - '0') + (pos[2] - '0');
+	if (pos[3] == ':' && g_ascii_isdigit (pos[4]) && g_ascii_isdigit (pos[5]))
+		minutes = 10 * (pos[4] - '0') + (pos[5] - '0');
+	else if (g_ascii_isdigit (pos[3]) && g_ascii_isdigit (pos[4]))
+		minutes = 10 * (pos[3] - '0') + (pos[4] - '0');
+
+	*offset = (hours * 60 + minutes) * 60;
+	if (*pos == '-')
+		*offset = -*offset;
+
+	return pos + 3;
+}
+
 time_t
 date_parse_ISO8601 (const gchar *date)
 {
-	struct tm	tm;
-	time_t		t, t2, offset = 0;
-	gboolean	success = FALSE;
-	gchar *pos;
-	
+	const gchar	*pos;
+	gint		year, month, day, hour = 0, minute = 0, second = 0;
+	time_t		offset = 0;
+
 	g_assert (date != NULL);
-	
-	memset (&tm, 0, sizeof (struct tm));
-	
+
 	/* we expect at least something like "2003-08-07T15:28:19" and
 	   don't require the second fractions and the timezone info
 
 	   the most specific format:   YYYY-MM-DDThh:mm:ss.sTZD
+
+	   as some feeds use a space instead of the "T" this is accepted
+	   too, if neither is present only the date is used
 	 */
-	 
+
+	pos = date_skip_space (date);
+	if (!(pos = date_parse_number (pos, 4, &year)) || *pos++ != '-' ||
+	    !(pos = date_parse_number (pos, 2, &month)) || *pos++ != '-' ||
+	    !(pos = date_parse_number (pos, 2, &day)) ||
+	    month < 1 || month > 12 || day < 1 || day > 31) {
+		debug0 (DEBUG_PARSING, "Invalid ISO8601 date format! Ignoring <dc:date> information!");
+		return 0;
+	}
+
 	/* full specified variant */
-	pos = strptime (date, "%t%Y-%m-%dT%H:%M%t", &tm);
-	if (pos) {
-		/* Parse seconds */
-		if (*pos == ':')
-			pos++;
-		if (isdigit (pos[0]) && !isdigit (pos[1])) {
-			tm.tm_sec = pos[0] - '0';
-			pos++;
-		} else if (isdigit (pos[0]) && isdigit (pos[1])) {
-			tm.tm_sec = 10*(pos[0]-'0') + pos[1] - '0';
-			pos +=2;
-		}
-		/* Parse second fractions */
-		if (*pos == '.') {
-			while (*pos == '.' || isdigit (pos[0]))
+	if ((*pos == 'T' || *pos == 't' || *pos == ' ') &&
+	    g_ascii_isdigit (pos[1])) {
+		const gchar *time = pos + 1;
+
+		if ((time = date_parse_number (time, 2, &hour)) && *time++ == ':' &&
+		    (time = date_parse_number (time, 2, &minute)) &&
+		    hour <= 23 && minute <= 59) {
+			pos = date_skip_space (time);
+
+			/* Parse seconds */
+			if (*pos == ':')
 				pos++;
-		}
-		/* Parse timezone */
-		if (*pos == 'Z')
-			offset = 0;
-		else if ((*pos == '+' || *pos == '-') && isdigit (pos[1]) && isdigit (pos[2]) && strlen (pos) >= 3) {
-			offset = (10*(pos[1] - '0') + (pos[2] - '0')) * 60 * 60;
-			
-			if (pos[3] == ':' && isdigit (pos[4]) && isdigit (pos[5]))
-				offset +=  (10*(pos[4] - '0') + (pos[5] - '0')) * 60;
-			else if (isdigit (pos[3]) && isdigit (pos[4]))
-				offset +=  (10*(pos[3] - '0') + (pos[4] - '0')) * 60;
-			
-			offset *= (pos[0] == '+') ? 1 : -1;
+			if (g_ascii_isdigit (*pos))
+				pos = date_parse_number (pos, 2, &second);
 
-		}
-		success = TRUE;
-	/* only date */
-	} else if (NULL != strptime (date, "%t%Y-%m-%d", &tm)) {
-		success = TRUE;
-	}
-	/* there were others combinations too... */
-
-	if (success) {
-		if ((time_t)(-1) != (t = mktime (&tm))) {
-			/* Correct for the local timezone*/
-			struct tm tmp_tm;
-			
-			t = t - offset;
-			gmtime_r (&t, &tmp_tm);
-			t2 = mktime (&tmp_tm);
-			t = t - (t2 - t);
-			
-			return t;
+			/* Parse second fractions */
+			if (*pos == '.') {
+				while (*pos == '.' || g_ascii_isdigit (*pos))
+					pos++;
+			}
+
+			/* Parse timezone */
+			if (*pos != 'Z')
+				date_parse_numeric_tz (pos, &offset);
 		} else {
-			debug0 (DEBUG_PARSING, "Internal error! time conversion error! mktime failed!");
+			hour = minute = 0;
 		}
-	} else {
-		debug0 (DEBUG_PARSING, "Invalid ISO8601 date format! Ignoring <dc:date> information!");
 	}
-	
-	return 0;
+
+	return date_to_time (year, month, day, hour, minute, second) - offset;
 }
 
 /* in theory, we'd need only the RFC822 timezones here
@@ -297,40 +372,60 @@ static struct {
 
 /** @returns timezone offset in seconds */
 static time_t
-date_parse_rfc822_tz (char *token)
+date_parse_rfc822_tz (const gchar *token)
 {
 	int offset = 0;
 	const char *inptr = token;
 	int num_timezones = sizeof (tz_offsets) / sizeof ((tz_offsets)[0]);
+	time_t numericOffset;
+	int t;
 
-	if (*inptr == '+' || *inptr == '-') {
-		offset = atoi (inptr);
-	} else {
-		int t;
+	if (date_parse_numeric_tz (inptr, &numericOffset))
+		return numericOffset;
 
-		if (*inptr == '(')
-			inptr++;
+	if (*inptr == '(')
+		inptr++;
 
-		for (t = 0; t < num_timezones; t++)
-			if (!strncmp (inptr, tz_offsets[t].name, strlen (tz_offsets[t].name))) {
-				offset = tz_offsets[t].offset;
-				break;
-			}
-	}
+	for (t = 0; t < num_timezones; t++)
+		if (!strncmp (inptr, tz_offsets[t].name, strlen (tz_offsets[t].name))) {
+			offset = tz_offsets[t].offset;
+			break;
+		}
 	
 	return 60 * ((offset / 100) * 60 + (offset % 100));
 }
 
+/**
+ * Parses an English month name or abbreviation ignoring case.
+ *
+ * @returns position after the name or NULL if there is no month name
+ */
+static const gchar *
+date_parse_month (const gchar *pos, gint *month)
+{
+	static const gchar *months[] = { "jan", "feb", "mar", "apr", "may", "jun",
+	                                 "jul", "aug", "sep", "oct", "nov", "dec" };
+	gint	i;
+
+	for (i = 0; i < 12; i++) {
+		if (!g_ascii_strncasecmp (pos, months[i], 3)) {
+			*month = i + 1;
+			/* skip the rest of a full month name */
+			pos += 3;
+			while (g_ascii_isalpha (*pos))
+				pos++;
+			return pos;
+		}
+	}
+
+	return NULL;
+}
+
 time_t
 date_parse_RFC822 (const gchar *date)
 {
-	struct tm	tm;
-	time_t		t, t2;
-	char 		*oldlocale;
-	char		*pos;
-	gboolean	success = FALSE;
-
-	memset (&tm, 0, sizeof (struct tm));
+	const gchar	*pos, *end;
+	gint		year, month, day, hour, minute, second = 0;
 
 	/* we expect at least something like "03 Dec 12 01:38:34" 
 	   and don't require a day of week or the timezone
@@ -339,49 +434,41 @@ date_parse_RFC822 (const gchar *date)
 	 */
 	
 	/* skip day of week */
-	pos = g_utf8_strchr(date, -1, ',');
+	pos = strchr (date, ',');
 	if (pos)
 		date = ++pos;
 
-	/* we expect English month names, so we set the locale */
-	oldlocale = g_strdup (setlocale (LC_TIME, NULL));
-	setlocale (LC_TIME, "C");
-	
-	/* standard format with seconds and 4 digit year */
-	if (NULL != (pos = strptime ((const char *)date, " %d %b %Y %T", &tm)))
-		success = TRUE;
-	/* non-standard format without seconds and 4 digit year */
-	else if (NULL != (pos = strptime ((const char *)date, " %d %b %Y %H:%M", &tm)))
-		success = TRUE;
-	/* non-standard format with seconds and 2 digit year */
-	else if (NULL != (pos = strptime ((const char *)date, " %d %b %y %T", &tm)))
-		success = TRUE;
-	/* non-standard format without seconds 2 digit year */
-	else if (NULL != (pos = strptime ((const char *)date, " %d %b %y %H:%M", &tm)))
-		success = TRUE;
-	
-	while (pos && *pos != '\0' && isspace ((int)*pos))       /* skip whitespaces before timezone */
-		pos++;
-	
-	if (oldlocale) {
-		setlocale (LC_TIME, oldlocale);	/* and reset it again */
-		g_free (oldlocale);
-	}
-	
-	if (success) {
-		if ((time_t)(-1) != (t = mktime (&tm))) {
-			/* GMT time, with no daylight savings time
-			   correction. (Usually, there is no daylight savings
-			   time since the input is GMT.) */
-			t = t - date_parse_rfc822_tz (pos);
-			t2 = mktime (gmtime(&t));
-			t = t - (t2 - t);
-			return t;
-		} else {
-			debug0 (DEBUG_PARSING, "internal error! time conversion error! mktime failed!");
-		}
-	}
-	
-	return 0;
-}
+	pos = date_skip_space (date);
+	if (!(pos = date_parse_number (pos, 2, &day)))
+		return 0;
+	pos = date_skip_space (pos);
+	if (!(pos = date_parse_month (pos, &month)))
+		return 0;
+	pos = date_skip_space (pos);
+	if (!(end = date_parse_number (pos, 4, &year)))
+		return 0;
+
+	/* 2 and 3 digit years as defined by RFC 2822 section 4.3 */
+	if (end - pos == 2 && year < 50)
+		year += 2000;
+	else if (end - pos <= 3)
+		year += 1900;
+
+	pos = date_skip_space (end);
+	if (!(pos = date_parse_number (pos, 2, &hour)) || *pos++ != ':' ||
+	    !(pos = date_parse_number (pos, 2, &minute)))
+		return 0;
+
+	/* seconds are optional */
+	if (*pos == ':' && g_ascii_isdigit (pos[1]))
+		pos = date_parse_number (pos + 1, 2, &second);
 
+	if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+		return 0;
+
+	/* skip whitespaces before timezone */
+	pos = date_skip_space (pos);
+
+	/* GMT time, with no daylight savings time correction */
+	return date_to_time (year, month, day, hour, minute, second) - date_parse_rfc822_tz (pos);
+}
@@ -37,22 +37,23 @@
 gchar * date_format (time_t date, const gchar *date_format);
 
 /**
- * Parses a ISO8601 date.
+ * Parses a ISO8601 date. Does not depend on the locale
+ * or the local timezone.
  *
  * @param date		the date string to parse
  *
- * @returns timestamp
+ * @returns UTC timestamp (0 on error)
  */
 time_t date_parse_ISO8601 (const gchar *date);
 
 /**
- * Parses a RFC822 format date. This FAILS if a timezone string is
- * specified such as EDT or EST and that timezone is in daylight
- * savings time.
+ * Parses a RFC822 format date. Expects English month names
+ * regardless of the locale. Named timezones are resolved using
+ * a fixed table of well-known abbreviations.
  *
  * @param date		the date string to parse
  *
- * @returns timestamp (GMT, no daylight savings time)
+ * @returns UTC timestamp (0 on error)
  */
 time_t date_parse_RFC822 (const gchar *date);
 
@@ -30,6 +30,7 @@
 #include "itemset.h"
 #include "metadata.h"
 #include "vfolder.h"
+#include "xml.h"
 
 /* You can find a schema description used by this version of Liferea at:
    http://lzone.de/wiki/doku.php?id=liferea:v1.8:db_schema */
@@ -40,6 +41,30 @@ gboolean searchFolderRebuild = FALSE;
 /** hash of all prepared statements */
 static GHashTable *statements = NULL;
 
+/** mapping of node id strings to integer node keys */
+static GHashTable *nodeKeys = NULL;
+
+/** mapping of integer node keys to node id strings */
+static GHashTable *nodeIds = NULL;
+
+/** item state changes not yet written (item id -> DB_ITEM_STATE_* flags) */
+static GHashTable *pendingStates = NULL;
+
+/** timeout source id for writing the pending item states */
+static guint pendingStatesFlushId = 0;
+
+/** descriptions stripped after loading, not yet written (item id -> description) */
+static GHashTable *pendingDescriptions = NULL;
+
+/* Item state changes are written with a delay of at most 
+   DB_ITEM_STATE_FLUSH_DELAY milliseconds, which bounds the
+   number of state changes that can be lost on a crash. */
+#define DB_ITEM_STATE_FLUSH_DELAY	1000
+
+#define DB_ITEM_STATE_READ	(1<<0)
+#define DB_ITEM_STATE_FLAGGED	(1<<1)
+#define DB_ITEM_STATE_UPDATED	(1<<2)
+
 static void db_view_remove (const gchar *id);
 
 static void
@@ -85,6 +110,116 @@ db_get_statement (const gchar *name)
 	return statement;
 }
 
+/* Node id mapping
+
+   The string node ids (as used in the OPML feed list) are not stored
+   in the items, search_folder_items and subscription_metadata tables.
+   Those reference the integer node_key of the node_ids table instead
+   to keep indices small and joins fast. The mapping is kept in memory
+   in both directions. Node ids are interned so that loaded items can
+   share them instead of duplicating them. */
+
+static void
+db_node_keys_add (gint key, const gchar *id)
+{
+	const gchar	*tmp = g_intern_string (id);
+
+	g_hash_table_insert (nodeKeys, (gpointer)tmp, GINT_TO_POINTER (key));
+	g_hash_table_insert (nodeIds, GINT_TO_POINTER (key), (gpointer)tmp);
+}
+
+static void
+db_node_keys_load (void)
+{
+	sqlite3_stmt	*stmt;
+
+	nodeKeys = g_hash_table_new (g_str_hash, g_str_equal);
+	nodeIds = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	db_prepare_stmt (&stmt, "SELECT node_key, node_id FROM node_ids");
+	while (sqlite3_step (stmt) == SQLITE_ROW)
+		db_node_keys_add (sqlite3_column_int (stmt, 0), sqlite3_column_text (stmt, 1));
+	sqlite3_finalize (stmt);
+
+	debug1 (DEBUG_DB, "loaded %d node keys", g_hash_table_size (nodeKeys));
+}
+
+/**
+ * Returns the integer key for the given node id. Creates a new
+ * mapping if the node id is not yet known.
+ *
+ * @param id	the node id (or NULL)
+ *
+ * @returns node key (0 for NULL)
+ */
+static gint
+db_node_key (const gchar *id)
+{
+	sqlite3_stmt	*stmt;
+	gpointer	key;
+	gint		res;
+
+	if (!id)
+		return 0;
+
+	if (g_hash_table_lookup_extended (nodeKeys, id, NULL, &key))
+		return GPOINTER_TO_INT (key);
+
+	stmt = db_get_statement ("nodeKeyInsertStmt");
+	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	res = sqlite3_step (stmt);
+	sqlite3_finalize (stmt);
+
+	if (SQLITE_DONE != res)
+		g_error ("Could not create node key for node id %s (error code=%d, %s)", id, res, sqlite3_errmsg (db));
+
+	res = (gint)sqlite3_last_insert_rowid (db);
+	db_node_keys_add (res, id);
+	debug2 (DEBUG_DB, "new node key %d for node id %s", res, id);
+
+	return res;
+}
+
+/**
+ * Returns the integer key for the given node id without creating
+ * a mapping. To be used when only reading or removing rows, so that
+ * lookups of node ids without any rows do not grow the node_ids table.
+ *
+ * @param id	the node id (or NULL)
+ *
+ * @returns node key (0 for NULL or unknown node ids, matching no rows)
+ */
+static gint
+db_node_key_lookup (const gchar *id)
+{
+	if (!id)
+		return 0;
+
+	return GPOINTER_TO_INT (g_hash_table_lookup (nodeKeys, id));
+}
+
+/**
+ * Returns the node id string for the given integer node key.
+ *
+ * @param key	the node key
+ *
+ * @returns node id (or NULL if unknown, do not free)
+ */
+static const gchar *
+db_node_id (gint key)
+{
+	return (const gchar *)g_hash_table_lookup (nodeIds, GINT_TO_POINTER (key));
+}
+
+static void
+db_bind_node_key (sqlite3_stmt *stmt, gint index, const gchar *id)
+{
+	if (id)
+		sqlite3_bind_int (stmt, index, db_node_key (id));
+	else
+		sqlite3_bind_null (stmt, index);
+}
+
 static void
 db_exec (const gchar *sql)
 {
@@ -228,6 +363,81 @@ db_vacuum (void)
 	}
 }
 
+/* Item metadata is stored as one packed blob per item in the
+   item_metadata table. The blob is a sequence of NUL-terminated
+   key and value strings in list order. There are no side tables
+   for categories or enclosures: search folder rules only check
+   items that are loaded, with their metadata already unpacked. */
+
+static void
+db_item_metadata_pack_cb (const gchar *key,
+                          const gchar *value,
+                          guint index,
+                          gpointer user_data)
+{
+	GString	*packed = (GString *)user_data;
+
+	g_string_append_len (packed, key, strlen (key) + 1);
+	g_string_append_len (packed, value, strlen (value) + 1);
+}
+
+/* This method is only used for migration from old schema versions */
+static void
+db_item_metadata_migrate (void)
+{
+	sqlite3_stmt	*select, *insert;
+	GString		*packed;
+	gint		itemId = 0, res;
+
+	debug0 (DEBUG_DB, "migrating from schema version 11 to 12 (packed item metadata)");
+	debug_start_measurement (DEBUG_DB);
+
+	db_begin_transaction ();
+
+	db_exec ("CREATE TABLE item_metadata ("
+	         "   item_id		INTEGER,"
+	         "   data		BLOB,"
+	         "   PRIMARY KEY (item_id)"
+	         ");");
+
+	db_prepare_stmt (&select, "SELECT item_id, key, value FROM metadata ORDER BY item_id, nr");
+	db_prepare_stmt (&insert, "INSERT INTO item_metadata (item_id, data) VALUES (?,?)");
+	packed = g_string_sized_new (1024);
+
+	do {
+		res = sqlite3_step (select);
+
+		/* Flush the blob of the previous item on item change */
+		if (itemId && ((SQLITE_ROW != res) || (itemId != sqlite3_column_int (select, 0)))) {
+			sqlite3_reset (insert);
+			sqlite3_bind_int  (insert, 1, itemId);
+			sqlite3_bind_blob (insert, 2, packed->str, packed->len, SQLITE_TRANSIENT);
+			if (SQLITE_DONE != sqlite3_step (insert))
+				g_warning ("Migrating metadata of item %d failed (%s)", itemId, sqlite3_errmsg (db));
+			g_string_truncate (packed, 0);
+		}
+
+		if (SQLITE_ROW == res) {
+			itemId = sqlite3_column_int (select, 0);
+			if (sqlite3_column_text (select, 1) && sqlite3_column_text (select, 2))
+				db_item_metadata_pack_cb (sqlite3_column_text (select, 1),
+				                          sqlite3_column_text (select, 2),
+				                          0, packed);
+		}
+	} while (SQLITE_ROW == res);
+
+	g_string_free (packed, TRUE);
+	sqlite3_finalize (insert);
+	sqlite3_finalize (select);
+
+	db_exec ("DROP TABLE metadata;");
+	db_set_schema_version (12);
+
+	db_end_transaction ();
+
+	debug_end_measurement (DEBUG_DB, "metadata migration");
+}
+
 static void
 db_open (void)
 {
@@ -248,7 +458,7 @@ db_open (void)
 	db_exec("PRAGMA synchronous=NORMAL");
 }
 
-#define SCHEMA_TARGET_VERSION 10
+#define SCHEMA_TARGET_VERSION 14
 
 /* opening or creation of database */
 void
@@ -433,6 +643,100 @@ db_init (void)
 
 			searchFolderRebuild = TRUE;
 		}
+
+		if (db_get_schema_version () == 10) {
+			/* Replace node id strings with integer node keys */
+			debug0 (DEBUG_DB, "migrating from schema version 10 to 11 (integer node keys)");
+			db_exec ("BEGIN; "
+			         "DROP TRIGGER IF EXISTS item_removal; "
+			         "DROP TRIGGER IF EXISTS subscription_removal; "
+			         "CREATE TABLE node_ids ("
+			         "   node_key		INTEGER PRIMARY KEY,"
+			         "   node_id		TEXT UNIQUE"
+			         "); "
+			         "INSERT INTO node_ids (node_id) SELECT id FROM ("
+			         "   SELECT node_id AS id FROM node "
+			         "   UNION SELECT node_id FROM items "
+			         "   UNION SELECT parent_node_id FROM items "
+			         "   UNION SELECT node_id FROM search_folder_items "
+			         "   UNION SELECT parent_node_id FROM search_folder_items "
+			         "   UNION SELECT node_id FROM subscription_metadata"
+			         ") WHERE id IS NOT NULL; "
+			         "ALTER TABLE items RENAME TO items_old; "
+			         "CREATE TABLE items ("
+			         "   item_id		INTEGER,"
+			         "   parent_item_id     INTEGER,"
+			         "   node_id		INTEGER,"
+			         "   parent_node_id     INTEGER,"
+			         "   title		TEXT,"
+			         "   read		INTEGER,"
+			         "   updated		INTEGER,"
+			         "   popup		INTEGER,"
+			         "   marked		INTEGER,"
+			         "   source		TEXT,"
+			         "   source_id		TEXT,"
+			         "   valid_guid		INTEGER,"
+			         "   description	TEXT,"
+			         "   date		INTEGER,"
+			         "   comment_feed_id	TEXT,"
+			         "   comment            INTEGER,"
+			         "   PRIMARY KEY (item_id)"
+			         "); "
+			         "INSERT INTO items SELECT item_id, parent_item_id, n.node_key, p.node_key, title, read, updated, popup, marked, source, source_id, valid_guid, description, date, comment_feed_id, comment "
+			         "   FROM items_old "
+			         "   LEFT JOIN node_ids n ON n.node_id = items_old.node_id "
+			         "   LEFT JOIN node_ids p ON p.node_id = items_old.parent_node_id; "
+			         "DROP TABLE items_old; "
+			         "ALTER TABLE search_folder_items RENAME TO search_folder_items_old; "
+			         "CREATE TABLE search_folder_items ("
+			         "   node_id            INTEGER,"
+			         "   parent_node_id     INTEGER,"
+			         "   item_id		INTEGER,"
+			         "   PRIMARY KEY (node_id, item_id)"
+			         "); "
+			         "INSERT INTO search_folder_items SELECT n.node_key, p.node_key, item_id "
+			         "   FROM search_folder_items_old "
+			         "   JOIN node_ids n ON n.node_id = search_folder_items_old.node_id "
+			         "   LEFT JOIN node_ids p ON p.node_id = search_folder_items_old.parent_node_id; "
+			         "DROP TABLE search_folder_items_old; "
+			         "ALTER TABLE subscription_metadata RENAME TO subscription_metadata_old; "
+			         "CREATE TABLE subscription_metadata ("
+			         "   node_id            INTEGER,"
+			         "   nr                 INTEGER,"
+			         "   key                TEXT,"
+			         "   value              TEXT,"
+			         "   PRIMARY KEY (node_id, nr)"
+			         "); "
+			         "INSERT INTO subscription_metadata SELECT n.node_key, nr, key, value "
+			         "   FROM subscription_metadata_old "
+			         "   JOIN node_ids n ON n.node_id = subscription_metadata_old.node_id; "
+			         "DROP TABLE subscription_metadata_old; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',11); "
+			         "END;" );
+		}
+
+		if (db_get_schema_version () == 11)
+			db_item_metadata_migrate ();
+
+		if (db_get_schema_version () == 12) {
+			/* existing descriptions are stripped lazily when loaded */
+			debug0 (DEBUG_DB, "migrating from schema version 12 to 13 (adding description stripping version)");
+			db_exec ("BEGIN; "
+			         "ALTER TABLE items ADD COLUMN sanitized INTEGER; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',13); "
+			         "END;" );
+		}
+
+		if (db_get_schema_version () == 13) {
+			debug0 (DEBUG_DB, "migrating from schema version 13 to 14 (adding duplicate counts)");
+			db_exec ("BEGIN; "
+			         "ALTER TABLE items ADD COLUMN duplicates INTEGER; "
+			         "UPDATE items SET duplicates = "
+			         "   (SELECT COUNT(*) - 1 FROM items i WHERE i.source_id = items.source_id) "
+			         "   WHERE valid_guid = 1; "
+			         "REPLACE INTO info (name, value) VALUES ('schemaVersion',14); "
+			         "END;" );
+		}
 	}
 
 	if (SCHEMA_TARGET_VERSION != db_get_schema_version ())
@@ -451,8 +755,8 @@ db_init (void)
 	db_exec ("CREATE TABLE items ("
         	 "   item_id		INTEGER,"
 		 "   parent_item_id     INTEGER,"
-        	 "   node_id		TEXT," /* FIXME: migrate node ids to real integers */
-		 "   parent_node_id     TEXT," /* FIXME: migrate node ids to real integers */
+        	 "   node_id		INTEGER,"	/* node_ids.node_key */
+		 "   parent_node_id     INTEGER,"	/* node_ids.node_key */
         	 "   title		TEXT,"
         	 "   read		INTEGER,"
         	 "   updated		INTEGER,"
@@ -465,6 +769,8 @@ db_init (void)
         	 "   date		INTEGER,"
         	 "   comment_feed_id	TEXT,"
 		 "   comment            INTEGER,"
+		 "   sanitized		INTEGER,"	/* XHTML_STRIP_VERSION of the description */
+		 "   duplicates		INTEGER,"	/* number of other items with the same source_id */
 		 "   PRIMARY KEY (item_id)"
         	 ");");
 
@@ -475,15 +781,18 @@ db_init (void)
 	db_exec ("CREATE INDEX items_idx5 ON items (parent_item_id);");
 	db_exec ("CREATE INDEX items_idx6 ON items (parent_node_id);");
 		
-	db_exec ("CREATE TABLE metadata ("
+	db_exec ("CREATE TABLE item_metadata ("
+        	 "   item_id		INTEGER,"
+        	 "   data		BLOB,"	/* packed key/value list */
+        	 "   PRIMARY KEY (item_id)"
+        	 ");");
+
+	db_exec ("CREATE TABLE item_images ("
         	 "   item_id		INTEGER,"
-        	 "   nr              	INTEGER,"
-        	 "   key             	TEXT,"
-        	 "   value           	TEXT,"
-        	 "   PRIMARY KEY (item_id, nr)"
+        	 "   hash		TEXT"	/* image cache file name */
         	 ");");
 
-	db_exec ("CREATE INDEX metadata_idx ON metadata (item_id);");
+	db_exec ("CREATE UNIQUE INDEX item_images_idx ON item_images (item_id, hash);");
 		
 	db_exec ("CREATE TABLE subscription ("
         	 "   node_id            STRING,"
@@ -498,7 +807,7 @@ db_init (void)
 		 ");");
 
 	db_exec ("CREATE TABLE subscription_metadata ("
-        	 "   node_id            STRING,"
+        	 "   node_id            INTEGER,"	/* node_ids.node_key */
 		 "   nr                 INTEGER,"
 		 "   key                TEXT,"
 		 "   value              TEXT,"
@@ -520,11 +829,17 @@ db_init (void)
         	 ");");
 
 	db_exec ("CREATE TABLE search_folder_items ("
-	         "   node_id            STRING,"
-	         "   parent_node_id     STRING,"
+	         "   node_id            INTEGER,"	/* node_ids.node_key */
+	         "   parent_node_id     INTEGER,"	/* node_ids.node_key */
 	         "   item_id		INTEGER,"
 		 "   PRIMARY KEY (node_id, item_id)"
 		 ");");
+	db_exec ("CREATE INDEX search_folder_items_idx ON search_folder_items (item_id);");
+
+	db_exec ("CREATE TABLE node_ids ("
+	         "   node_key		INTEGER PRIMARY KEY,"
+	         "   node_id		TEXT UNIQUE"
+		 ");");
 
 	db_end_transaction ();
 	debug_end_measurement (DEBUG_DB, "table setup");
@@ -541,7 +856,7 @@ db_init (void)
 	   types (e.g. news bin) do contain items too. */
 	debug0 (DEBUG_DB, "Checking for items without a feed list node...\n");
 	db_exec ("DELETE FROM items WHERE comment = 0 AND node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
+        	 "(SELECT node_key FROM node_ids JOIN node ON node.node_id = node_ids.node_id);");
         	 
         debug0 (DEBUG_DB, "Checking for comments without parent item...\n");
 	db_exec ("BEGIN; "
@@ -554,15 +869,26 @@ db_init (void)
         
 	debug0 (DEBUG_DB, "Checking for search folder items without a feed list node...\n");
 	db_exec ("DELETE FROM search_folder_items WHERE parent_node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
+        	 "(SELECT node_key FROM node_ids JOIN node ON node.node_id = node_ids.node_id);");
 
 	debug0 (DEBUG_DB, "Checking for search folder items without a search folder...\n");
 	db_exec ("DELETE FROM search_folder_items WHERE node_id NOT IN "
-        	 "(SELECT node_id FROM node);");
+        	 "(SELECT node_key FROM node_ids JOIN node ON node.node_id = node_ids.node_id);");
+
+	debug0 (DEBUG_DB, "Checking for cached images of removed items...\n");
+	db_exec ("DELETE FROM item_images WHERE item_id NOT IN (SELECT item_id FROM items);");
 
 	debug0 (DEBUG_DB, "Checking for search folder with comments...\n");
 	db_exec ("DELETE FROM search_folder_items WHERE comment = 1;");
 			  
+	debug0 (DEBUG_DB, "Checking for unreferenced node keys...\n");
+	db_exec ("DELETE FROM node_ids WHERE node_id NOT IN (SELECT node_id FROM node) "
+	         "AND node_key NOT IN (SELECT node_id FROM items WHERE node_id IS NOT NULL) "
+	         "AND node_key NOT IN (SELECT parent_node_id FROM items WHERE parent_node_id IS NOT NULL) "
+	         "AND node_key NOT IN (SELECT node_id FROM search_folder_items WHERE node_id IS NOT NULL) "
+	         "AND node_key NOT IN (SELECT parent_node_id FROM search_folder_items WHERE parent_node_id IS NOT NULL) "
+	         "AND node_key NOT IN (SELECT node_id FROM subscription_metadata WHERE node_id IS NOT NULL);");
+
 	debug0 (DEBUG_DB, "DB cleanup finished. Continuing startup.");
 		
 	/* 4. Creating triggers (after cleanup so it is not slowed down by triggers) */
@@ -570,19 +896,26 @@ db_init (void)
 	/* This trigger does explicitely not remove comments! */
 	db_exec ("CREATE TRIGGER item_removal DELETE ON items "
         	 "BEGIN "
-		 "   DELETE FROM metadata WHERE item_id = old.item_id; "
+		 "   DELETE FROM item_metadata WHERE item_id = old.item_id; "
+		 "   DELETE FROM item_images WHERE item_id = old.item_id; "
 		 "   DELETE FROM search_folder_items WHERE item_id = old.item_id; "
         	 "END;");
 		
 	db_exec ("CREATE TRIGGER subscription_removal DELETE ON subscription "
         	 "BEGIN "
 		 "   DELETE FROM node WHERE node_id = old.node_id; "
-		 "   DELETE FROM subscription_metadata WHERE node_id = old.node_id; "
-		 "   DELETE FROM search_folder_items WHERE parent_node_id = old.node_id; "
+		 "   DELETE FROM subscription_metadata WHERE node_id = (SELECT node_key FROM node_ids WHERE node_id = old.node_id); "
+		 "   DELETE FROM search_folder_items WHERE parent_node_id = (SELECT node_key FROM node_ids WHERE node_id = old.node_id); "
         	 "END;");
 
 	/* Note: view counting triggers are set up in the view preparation code (see db_view_create()) */		
+
+	db_node_keys_load ();
+
 	/* prepare statements */
+
+	db_new_statement ("nodeKeyInsertStmt",
+	                  "INSERT INTO node_ids (node_id) VALUES (?)");
 	
 	db_new_statement ("itemsetLoadStmt",
 	                  "SELECT item_id FROM items WHERE node_id = ?");
@@ -624,8 +957,11 @@ db_init (void)
 		          "item_id,"
 			  "parent_item_id, "
 		          "node_id, "
-			  "parent_node_id "
-	                  " FROM items WHERE item_id = ?");      
+			  "parent_node_id, "
+			  "data, "
+			  "sanitized, "
+			  "duplicates "
+	                  " FROM items LEFT JOIN item_metadata USING (item_id) WHERE item_id = ?");      
 	
 	db_new_statement ("itemUpdateStmt",
 	                  "REPLACE INTO items ("
@@ -644,28 +980,44 @@ db_init (void)
 	                  "item_id,"
 	                  "parent_item_id,"
 	                  "node_id,"
-	                  "parent_node_id"
-	                  ") values (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
+	                  "parent_node_id,"
+	                  "sanitized,"
+	                  "duplicates"
+	                  ") values (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,"
+	                  "(SELECT duplicates FROM items WHERE item_id = ?13))");
 			
 	db_new_statement ("itemStateUpdateStmt",
 			  "UPDATE items SET read=?, marked=?, updated=? "
 			  "WHERE item_id=?");
 
+	db_new_statement ("itemDescriptionUpdateStmt",
+			  "UPDATE items SET description=?, sanitized=? "
+			  "WHERE item_id=?");
+
 	db_new_statement ("duplicatesFindStmt",
 	                  "SELECT item_id FROM items WHERE source_id = ?");
 			 
 	db_new_statement ("duplicateNodesFindStmt",
-	                  "SELECT node_id FROM items WHERE item_id IN "
-			  "(SELECT item_id FROM items WHERE source_id = ?)");
+	                  "SELECT node_id FROM items WHERE source_id = ? AND item_id != ?");
+
+	db_new_statement ("itemImageInsertStmt",
+	                  "INSERT OR IGNORE INTO item_images (item_id, hash) VALUES (?,?)");
+
+	db_new_statement ("itemImagesLoadStmt",
+	                  "SELECT DISTINCT hash FROM item_images");
+
+	db_new_statement ("duplicatesCountStmt",
+	                  "SELECT COUNT(*) FROM items WHERE source_id = ?");
+
+	db_new_statement ("duplicatesCountUpdateStmt",
+	                  "UPDATE items SET duplicates = ? WHERE source_id = ?");
 		       
 	db_new_statement ("duplicatesMarkReadStmt",
  	                  "UPDATE items SET read = 1, updated = 0 WHERE source_id = ?");
 						
-	db_new_statement ("metadataLoadStmt",
-	                  "SELECT key,value,nr FROM metadata WHERE item_id = ? ORDER BY nr");
-			
 	db_new_statement ("metadataUpdateStmt",
-	                  "REPLACE INTO metadata (item_id,nr,key,value) VALUES (?,?,?,?)");
+	                  "REPLACE INTO item_metadata (item_id,data) VALUES (?,?)");
+
 			
 	db_new_statement ("subscriptionUpdateStmt",
 	                  "REPLACE INTO subscription ("
@@ -708,12 +1060,19 @@ db_init (void)
 
 	db_new_statement ("itemRemoveFromSearchFolderStmt",
 	                  "DELETE FROM search_folder_items WHERE node_id =? AND item_id = ?;");
+
+	db_new_statement ("itemSearchFoldersLoadStmt",
+	                  "SELECT search_folder_items.node_id, items.read FROM search_folder_items "
+	                  "INNER JOIN items ON items.item_id = search_folder_items.item_id "
+	                  "WHERE search_folder_items.item_id = ?;");
 	                  
 	db_new_statement ("searchFolderLoadStmt",
 	                  "SELECT item_id FROM search_folder_items WHERE node_id = ?;");
 
 	db_new_statement ("searchFolderCountStmt",
-	                  "SELECT count(item_id) FROM search_folder_items WHERE node_id = ?;");
+	                  "SELECT count(*), count(CASE WHEN items.read = 0 THEN 1 END) FROM search_folder_items "
+	                  "INNER JOIN items ON items.item_id = search_folder_items.item_id "
+	                  "WHERE search_folder_items.node_id = ?;");
 
 	db_new_statement ("nodeIdListStmt",
 	                  "SELECT node_id FROM node;");
@@ -731,6 +1090,16 @@ db_deinit (void)
 {
 
 	debug_enter ("db_deinit");
+
+	db_item_state_flush ();
+	if (pendingStates) {
+		g_hash_table_destroy (pendingStates);
+		pendingStates = NULL;
+	}
+	if (pendingDescriptions) {
+		g_hash_table_destroy (pendingDescriptions);
+		pendingDescriptions = NULL;
+	}
 	
 	if (FALSE == sqlite3_get_autocommit (db))
 		g_warning ("Fatal: DB not in auto-commit mode. This is a bug. Data may be lost!");
@@ -739,6 +1108,13 @@ db_deinit (void)
 		g_hash_table_destroy (statements);	
 		statements = NULL;
 	}
+
+	if (nodeKeys) {
+		g_hash_table_destroy (nodeIds);
+		g_hash_table_destroy (nodeKeys);
+		nodeIds = NULL;
+		nodeKeys = NULL;
+	}
 		
 	if (SQLITE_OK != sqlite3_close (db))
 		g_warning ("DB close failed: %s", sqlite3_errmsg (db));
@@ -748,8 +1124,8 @@ db_deinit (void)
 	debug_exit ("db_deinit");
 }
 
-static GSList *
-db_metadata_list_append (GSList *metadata, const char *key, const char *value)
+static metadataListPtr
+db_metadata_list_append (metadataListPtr metadata, const char *key, const char *value)
 {
 	if (metadata_is_type_registered (key))
 		metadata = metadata_list_append (metadata, key, value);
@@ -759,69 +1135,94 @@ db_metadata_list_append (GSList *metadata, const char *key, const char *value)
 	return metadata;
 }
 
-static GSList *
-db_item_metadata_load(itemPtr item) 
+static metadataListPtr
+db_item_metadata_load (itemPtr item, const gchar *packed, gint len)
 {
-	GSList		*metadata = NULL;
-	sqlite3_stmt 	*stmt;
-	gint		res;
+	metadataListPtr	metadata = NULL;
+	const gchar	*end = packed + len;
 
-	stmt = db_get_statement ("metadataLoadStmt");
-	res = sqlite3_bind_int (stmt, 1, item->id);
-	if (SQLITE_OK != res)
-		g_error ("db_item_load_metadata: sqlite bind failed (error code %d)!", res);
+	while (packed && packed < end) {
+		const gchar *key = packed, *value, *next;
+
+		value = memchr (key, '\0', end - key);
+		if (!value || ++value >= end)
+			break;
+		next = memchr (value, '\0', end - value);
+		if (!next)
+			break;
+		packed = next + 1;
 
-	while (sqlite3_step (stmt) == SQLITE_ROW) {
-		const char *key, *value;
-		key = sqlite3_column_text(stmt, 0);
-		value = sqlite3_column_text(stmt, 1);
 		if (g_str_equal (key, "enclosure"))
 			item->hasEnclosure = TRUE;
-		metadata = db_metadata_list_append (metadata, key, value); 
+		metadata = db_metadata_list_append (metadata, key, value);
 	}
 
-	sqlite3_finalize (stmt);
-
 	return metadata;
 }
 
 static void
-db_item_metadata_update_cb (const gchar *key,
-                            const gchar *value,
-                            guint index,
-                            gpointer user_data) 
+db_item_metadata_update (itemPtr item)
 {
 	sqlite3_stmt	*stmt;
-	itemPtr		item = (itemPtr)user_data;
+	GString		*packed;
 	gint		res;
 
+	packed = g_string_sized_new (256);
+	metadata_list_foreach (item->metadata, db_item_metadata_pack_cb, packed);
+
 	stmt = db_get_statement ("metadataUpdateStmt");
 	sqlite3_bind_int  (stmt, 1, item->id);
-	sqlite3_bind_int  (stmt, 2, index);
-	sqlite3_bind_text (stmt, 3, key, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 4, value, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_blob (stmt, 2, packed->str, packed->len, SQLITE_TRANSIENT);
 	res = sqlite3_step (stmt);
 	if (SQLITE_DONE != res) 
-		g_warning ("Update in \"metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+		g_warning ("Update in \"item_metadata\" table failed (error code=%d, %s)", res, sqlite3_errmsg (db));
 
 	sqlite3_finalize (stmt);
-
+	g_string_free (packed, TRUE);
 }
 
+/* Item structure loading methods */
+
+/* Applies a not yet written state change to a freshly loaded item */
 static void
-db_item_metadata_update(itemPtr item) 
+db_item_state_overlay (itemPtr item)
 {
-	metadata_list_foreach(item->metadata, db_item_metadata_update_cb, item);
+	gpointer	value;
+	guint		state;
+
+	if (!pendingStates || !g_hash_table_lookup_extended (pendingStates, GUINT_TO_POINTER (item->id), NULL, &value))
+		return;
+
+	state = GPOINTER_TO_UINT (value);
+	item->readStatus = (state & DB_ITEM_STATE_READ)?TRUE:FALSE;
+	item->flagStatus = (state & DB_ITEM_STATE_FLAGGED)?TRUE:FALSE;
+	item->updateStatus = (state & DB_ITEM_STATE_UPDATED)?TRUE:FALSE;
 }
 
-/* Item structure loading methods */
+static gboolean db_item_state_flush_cb (gpointer user_data);
+
+/* Strips a description stored with older stripping rules and
+   remembers it to be written with the next state flush */
+static void
+db_item_description_sanitize (itemPtr item)
+{
+	if (!item_sanitize_description (item))
+		return;
+
+	if (!pendingDescriptions)
+		pendingDescriptions = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	g_hash_table_insert (pendingDescriptions, GUINT_TO_POINTER (item->id), g_strdup (item->description));
+
+	if (!pendingStatesFlushId)
+		pendingStatesFlushId = g_timeout_add (DB_ITEM_STATE_FLUSH_DELAY, db_item_state_flush_cb, NULL);
+}
 
 static itemPtr
-db_load_item_from_columns (sqlite3_stmt *stmt) 
+db_load_item_from_columns (sqlite3_stmt *stmt, itemArenaPtr arena) 
 {
 	const gchar	*tmp;
 
-	itemPtr item = item_new ();
+	itemPtr item = item_arena_item_new (arena);
 	
 	item->readStatus	= sqlite3_column_int (stmt, 1)?TRUE:FALSE;
 	item->updateStatus	= sqlite3_column_int (stmt, 2)?TRUE:FALSE;
@@ -829,27 +1230,32 @@ db_load_item_from_columns (sqlite3_stmt *stmt)
 	item->flagStatus	= sqlite3_column_int (stmt, 4)?TRUE:FALSE;
 	item->validGuid		= sqlite3_column_int (stmt, 7)?TRUE:FALSE;
 	item->time		= sqlite3_column_int (stmt, 9);
-	item->commentFeedId	= g_strdup (sqlite3_column_text (stmt, 10));
+	item->commentFeedId	= item_strdup (item, sqlite3_column_text (stmt, 10));
 	item->isComment		= sqlite3_column_int (stmt, 11);
 	item->id		= sqlite3_column_int (stmt, 12);
+	db_item_state_overlay (item);
 	item->parentItemId	= sqlite3_column_int (stmt, 13);
-	item->nodeId		= g_strdup (sqlite3_column_text (stmt, 14));
-	item->parentNodeId	= g_strdup (sqlite3_column_text (stmt, 15));
+	item->nodeId		= db_node_id (sqlite3_column_int (stmt, 14));
+	item->parentNodeId	= db_node_id (sqlite3_column_int (stmt, 15));
 
-	item->title		= g_strdup (sqlite3_column_text(stmt, 0));
-	item->sourceId		= g_strdup (sqlite3_column_text(stmt, 6));
+	item->title		= item_strdup (item, sqlite3_column_text(stmt, 0));
+	item->sourceId		= item_strdup (item, sqlite3_column_text(stmt, 6));
 	
 	tmp = sqlite3_column_text(stmt, 5);
 	if (tmp)
-		item->source = g_strdup (tmp);
+		item->source = item_strdup (item, tmp);
 		
 	tmp = sqlite3_column_text(stmt, 8);
 	if (tmp)
-		item->description = g_strdup (tmp);
+		item->description = item_strdup (item, tmp);
 	else
-		item->description = g_strdup ("");
+		item->description = item_strdup (item, "");
+
+	item->sanitized		= sqlite3_column_int (stmt, 17);
+	item->duplicates	= sqlite3_column_int (stmt, 18);
+	db_item_description_sanitize (item);
 
-	item->metadata = db_item_metadata_load (item);
+	item->metadata = db_item_metadata_load (item, sqlite3_column_blob (stmt, 16), sqlite3_column_bytes (stmt, 16));
 
 	return item;
 }
@@ -865,7 +1271,7 @@ db_itemset_load (const gchar *id)
 	itemSet->nodeId = (gchar *)id;
 
 	stmt = db_get_statement ("itemsetLoadStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 
 	while (sqlite3_step (stmt) == SQLITE_ROW) {
 		itemSet->ids = g_list_append (itemSet->ids, GUINT_TO_POINTER (sqlite3_column_int (stmt, 0)));
@@ -880,6 +1286,12 @@ db_itemset_load (const gchar *id)
 
 itemPtr
 db_item_load (gulong id) 
+{
+	return db_item_load_with_arena (id, NULL);
+}
+
+itemPtr
+db_item_load_with_arena (gulong id, itemArenaPtr arena) 
 {
 	sqlite3_stmt	*stmt;
 	itemPtr 	item = NULL;
@@ -891,7 +1303,7 @@ db_item_load (gulong id)
 	sqlite3_bind_int (stmt, 1, id);
 
 	if (sqlite3_step (stmt) == SQLITE_ROW) {
-		item = db_load_item_from_columns (stmt);
+		item = db_load_item_from_columns (stmt, arena);
 		sqlite3_step (stmt);
 	} else {
 		debug1 (DEBUG_DB, "Could not load item with id %lu!", id);
@@ -951,47 +1363,130 @@ db_item_search_folders_update (itemPtr item)
 	sqlite3_stmt	*stmt;
 	gint 		res;
 	GSList		*iter, *list;
-	
+	GHashTable	*current;
+	GHashTableIter	hiter;
+	gpointer	id, value;
+	gboolean	wasRead = FALSE;
+
+	/* Load the search folders the item currently belongs to, so
+	   that only membership changes need to be written. Also get
+	   the stored read state to pass counter deltas to the search
+	   folders instead of having them count all their items. */
+
+	current = g_hash_table_new (g_str_hash, g_str_equal);
+	stmt = db_get_statement ("itemSearchFoldersLoadStmt");
+	sqlite3_bind_int (stmt, 1, item->id);
+	while (sqlite3_step (stmt) == SQLITE_ROW) {
+		const gchar *nodeId = db_node_id (sqlite3_column_int (stmt, 0));
+		if (nodeId)
+			g_hash_table_insert (current, (gpointer)nodeId, NULL);
+		wasRead = sqlite3_column_int (stmt, 1)?TRUE:FALSE;
+	}
+	sqlite3_finalize (stmt);
+
+	if (pendingStates && g_hash_table_lookup_extended (pendingStates, GUINT_TO_POINTER (item->id), NULL, &value))
+		wasRead = (GPOINTER_TO_UINT (value) & DB_ITEM_STATE_READ)?TRUE:FALSE;
+
 	/* Add item to all search folders it now belongs to */
 
 	stmt = db_get_statement ("itemUpdateSearchFoldersStmt");
 	iter = list = vfolder_get_all_with_item_id (item);
 	while (iter) {
 		vfolderPtr vfolder = (vfolderPtr)iter->data;
+		iter = g_slist_next (iter);
+
+		if (g_hash_table_remove (current, vfolder->node->id)) {
+			/* already in there */
+			if (wasRead != item->readStatus)
+				vfolder_item_counts_changed (vfolder->node->id, 0, wasRead?1:-1);
+			continue;
+		}
+
+		vfolder_item_counts_changed (vfolder->node->id, 1, item->readStatus?0:1);
+
 		sqlite3_reset (stmt);
-		sqlite3_bind_text (stmt, 1, vfolder->node->id, -1, SQLITE_TRANSIENT);
-		sqlite3_bind_text (stmt, 2, item->nodeId, -1, SQLITE_TRANSIENT);
+		db_bind_node_key (stmt, 1, vfolder->node->id);
+		db_bind_node_key (stmt, 2, item->nodeId);
 		sqlite3_bind_int (stmt, 3, item->id);
 		res = sqlite3_step (stmt);
 
 		if (SQLITE_DONE != res) 
 			g_warning ("item add to search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
-		iter = g_slist_next (iter);
-
 	}
 	g_slist_free (list);
 
 	sqlite3_finalize (stmt);
 
-	/* Remove item from all search folders it does not belong
-	   (we do not check if it is in there, just remove it) */
+	/* Remove item from all search folders it no longer belongs to */
 
-	stmt = db_get_statement ("itemRemoveFromSearchFolderStmt");
-	iter = list = vfolder_get_all_without_item_id (item);
-	while (iter) {
-		vfolderPtr vfolder = (vfolderPtr)iter->data;
-		sqlite3_reset (stmt);
-		sqlite3_bind_text (stmt, 1, vfolder->node->id, -1, SQLITE_TRANSIENT);
-		sqlite3_bind_int (stmt, 2, item->id);
-		res = sqlite3_step (stmt);
+	if (g_hash_table_size (current) > 0) {
+		stmt = db_get_statement ("itemRemoveFromSearchFolderStmt");
+		g_hash_table_iter_init (&hiter, current);
+		while (g_hash_table_iter_next (&hiter, &id, NULL)) {
+			vfolder_item_counts_changed ((const gchar *)id, -1, wasRead?0:-1);
 
-		if (SQLITE_DONE != res) 
-			g_warning ("item remove from search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
-		iter = g_slist_next (iter);
+			sqlite3_reset (stmt);
+			sqlite3_bind_int (stmt, 1, db_node_key_lookup ((const gchar *)id));
+			sqlite3_bind_int (stmt, 2, item->id);
+			res = sqlite3_step (stmt);
+
+			if (SQLITE_DONE != res) 
+				g_warning ("item remove from search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+		}
+		sqlite3_finalize (stmt);
+	}
+
+	g_hash_table_destroy (current);
+}
+
+/* The search folder membership is removed by a trigger,
+   only pass the counter changes to the search folders */
+static void
+db_item_search_folders_remove (gulong id)
+{
+	sqlite3_stmt	*stmt;
+	GSList		*list = NULL, *iter;
+	gpointer	value;
+	gboolean	wasRead = FALSE;
 
+	stmt = db_get_statement ("itemSearchFoldersLoadStmt");
+	sqlite3_bind_int (stmt, 1, id);
+	while (sqlite3_step (stmt) == SQLITE_ROW) {
+		const gchar *nodeId = db_node_id (sqlite3_column_int (stmt, 0));
+		if (nodeId)
+			list = g_slist_prepend (list, (gpointer)nodeId);
+		wasRead = sqlite3_column_int (stmt, 1)?TRUE:FALSE;
 	}
+	sqlite3_finalize (stmt);
+
+	if (pendingStates && g_hash_table_lookup_extended (pendingStates, GUINT_TO_POINTER (id), NULL, &value))
+		wasRead = (GPOINTER_TO_UINT (value) & DB_ITEM_STATE_READ)?TRUE:FALSE;
+
+	for (iter = list; iter; iter = g_slist_next (iter))
+		vfolder_item_counts_changed ((const gchar *)iter->data, -1, wasRead?0:-1);
 	g_slist_free (list);
+}
+
+/* Updates the duplicate count of all items with the GUID of a new item */
+static void
+db_item_duplicates_update (itemPtr item)
+{
+	sqlite3_stmt	*stmt;
+	guint		count = 0;
 
+	stmt = db_get_statement ("duplicatesCountStmt");
+	sqlite3_bind_text (stmt, 1, item->sourceId, -1, SQLITE_TRANSIENT);
+	if (sqlite3_step (stmt) == SQLITE_ROW)
+		count = sqlite3_column_int (stmt, 0);
+	sqlite3_finalize (stmt);
+
+	item->duplicates = (count > 0)?count - 1:0;
+
+	stmt = db_get_statement ("duplicatesCountUpdateStmt");
+	sqlite3_bind_int  (stmt, 1, item->duplicates);
+	sqlite3_bind_text (stmt, 2, item->sourceId, -1, SQLITE_TRANSIENT);
+	if (sqlite3_step (stmt) != SQLITE_DONE)
+		g_warning ("item duplicate count update failed (%s)", sqlite3_errmsg (db));
 	sqlite3_finalize (stmt);
 }
 
@@ -1000,18 +1495,32 @@ db_item_update (itemPtr item)
 {
 	sqlite3_stmt	*stmt;
 	gint		res;
+	gboolean	isNew = FALSE;
 	
 	debug2 (DEBUG_DB, "update of item \"%s\" (id=%lu)", item->title, item->id);
 	debug_start_measurement (DEBUG_DB);
-	
+
 	db_begin_transaction ();
 
 	if (!item->id) {
 		db_item_set_id (item);
+		isNew = TRUE;
 
 		debug1(DEBUG_DB, "insert into table \"items\": \"%s\"", item->title);	
 	}
 
+	/* needs the stored state, so do this before updating the item */
+	db_item_search_folders_update (item);
+
+	/* the item state is written below, a pending change is obsolete */
+	if (pendingStates)
+		g_hash_table_remove (pendingStates, GUINT_TO_POINTER (item->id));
+	if (pendingDescriptions)
+		g_hash_table_remove (pendingDescriptions, GUINT_TO_POINTER (item->id));
+
+	/* usually done when merging already, but never store unstripped descriptions */
+	item_sanitize_description (item);
+
 	/* Update the item... */
 	stmt = db_get_statement ("itemUpdateStmt");
 	sqlite3_bind_text (stmt, 1,  item->title, -1, SQLITE_TRANSIENT);
@@ -1028,8 +1537,9 @@ db_item_update (itemPtr item)
 	sqlite3_bind_int  (stmt, 12, item->isComment?1:0);
 	sqlite3_bind_int  (stmt, 13, item->id);
 	sqlite3_bind_int  (stmt, 14, item->parentItemId);
-	sqlite3_bind_text (stmt, 15, item->nodeId, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 16, item->parentNodeId, -1, SQLITE_TRANSIENT);
+	db_bind_node_key  (stmt, 15, item->nodeId);
+	db_bind_node_key  (stmt, 16, item->parentNodeId);
+	sqlite3_bind_int  (stmt, 17, item->sanitized);
 
 	res = sqlite3_step (stmt);
 
@@ -1038,19 +1548,30 @@ db_item_update (itemPtr item)
 
 	sqlite3_finalize (stmt);
 
+	if (isNew && item->validGuid && item->sourceId)
+		db_item_duplicates_update (item);
+
 	db_item_metadata_update (item);
-	db_item_search_folders_update (item);
 
 	db_end_transaction ();
 
 	debug_end_measurement (DEBUG_DB, "item update");
 }
 
+static gboolean
+db_item_state_flush_cb (gpointer user_data)
+{
+	pendingStatesFlushId = 0;
+	db_item_state_flush ();
+
+	return FALSE;
+}
+
 void
 db_item_state_update (itemPtr item)
 {
-	sqlite3_stmt	*stmt;
-	
+	guint	state = 0;
+
 	if (!item->id) {
 		db_item_update (item);
 		return;
@@ -1058,21 +1579,93 @@ db_item_state_update (itemPtr item)
 
 	db_item_search_folders_update (item);
 
+	/* Remember the new state and write it later together
+	   with all other state changes in one transaction */
+	if (item->readStatus)
+		state |= DB_ITEM_STATE_READ;
+	if (item->flagStatus)
+		state |= DB_ITEM_STATE_FLAGGED;
+	if (item->updateStatus)
+		state |= DB_ITEM_STATE_UPDATED;
+
+	if (!pendingStates)
+		pendingStates = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_hash_table_insert (pendingStates, GUINT_TO_POINTER (item->id), GUINT_TO_POINTER (state));
+
+	if (!pendingStatesFlushId)
+		pendingStatesFlushId = g_timeout_add (DB_ITEM_STATE_FLUSH_DELAY, db_item_state_flush_cb, NULL);
+}
+
+void
+db_item_state_flush (void)
+{
+	sqlite3_stmt	*stmt;
+	GHashTableIter	iter;
+	gpointer	id, value;
+	gboolean	transaction;
+
+	if (pendingStatesFlushId) {
+		g_source_remove (pendingStatesFlushId);
+		pendingStatesFlushId = 0;
+	}
+
+	if ((!pendingStates || (0 == g_hash_table_size (pendingStates))) &&
+	    (!pendingDescriptions || (0 == g_hash_table_size (pendingDescriptions))))
+		return;
+
+	debug2 (DEBUG_DB, "writing %u item state changes and %u stripped descriptions",
+	        pendingStates?g_hash_table_size (pendingStates):0,
+	        pendingDescriptions?g_hash_table_size (pendingDescriptions):0);
 	debug_start_measurement (DEBUG_DB);
-	
-	stmt = db_get_statement ("itemStateUpdateStmt");
-	sqlite3_bind_int (stmt, 1, item->readStatus?1:0);
-	sqlite3_bind_int (stmt, 2, item->flagStatus?1:0);
-	sqlite3_bind_int (stmt, 3, item->updateStatus?1:0);
-	sqlite3_bind_int (stmt, 4, item->id);
-
-	if (sqlite3_step (stmt) != SQLITE_DONE) 
-		g_warning ("item state update failed (%s)", sqlite3_errmsg (db));
-	
-	sqlite3_finalize (stmt);
 
-	debug_end_measurement (DEBUG_DB, "item state update");
+	/* might be called from within a transaction */
+	transaction = sqlite3_get_autocommit (db);
+	if (transaction)
+		db_begin_transaction ();
+
+	if (pendingStates) {
+		stmt = db_get_statement ("itemStateUpdateStmt");
+
+		g_hash_table_iter_init (&iter, pendingStates);
+		while (g_hash_table_iter_next (&iter, &id, &value)) {
+			guint state = GPOINTER_TO_UINT (value);
+
+			sqlite3_reset (stmt);
+			sqlite3_bind_int (stmt, 1, (state & DB_ITEM_STATE_READ)?1:0);
+			sqlite3_bind_int (stmt, 2, (state & DB_ITEM_STATE_FLAGGED)?1:0);
+			sqlite3_bind_int (stmt, 3, (state & DB_ITEM_STATE_UPDATED)?1:0);
+			sqlite3_bind_int (stmt, 4, GPOINTER_TO_UINT (id));
+
+			if (sqlite3_step (stmt) != SQLITE_DONE) 
+				g_warning ("item state update failed (%s)", sqlite3_errmsg (db));
+		}
+
+		sqlite3_finalize (stmt);
+		g_hash_table_remove_all (pendingStates);
+	}
+
+	if (pendingDescriptions) {
+		stmt = db_get_statement ("itemDescriptionUpdateStmt");
+
+		g_hash_table_iter_init (&iter, pendingDescriptions);
+		while (g_hash_table_iter_next (&iter, &id, &value)) {
+			sqlite3_reset (stmt);
+			sqlite3_bind_text (stmt, 1, (gchar *)value, -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int  (stmt, 2, XHTML_STRIP_VERSION);
+			sqlite3_bind_int  (stmt, 3, GPOINTER_TO_UINT (id));
+
+			if (sqlite3_step (stmt) != SQLITE_DONE) 
+				g_warning ("item description update failed (%s)", sqlite3_errmsg (db));
+		}
+
+		sqlite3_finalize (stmt);
+		g_hash_table_remove_all (pendingDescriptions);
+	}
+
+	if (transaction)
+		db_end_transaction ();
 
+	debug_end_measurement (DEBUG_DB, "item state update");
 }
 
 void
@@ -1082,6 +1675,13 @@ db_item_remove (gulong id)
 	gint		res;
 	
 	debug1 (DEBUG_DB, "removing item with id %lu", id);
+
+	db_item_search_folders_remove (id);
+
+	if (pendingStates)
+		g_hash_table_remove (pendingStates, GUINT_TO_POINTER (id));
+	if (pendingDescriptions)
+		g_hash_table_remove (pendingDescriptions, GUINT_TO_POINTER (id));
 	
 	stmt = db_get_statement ("itemsetRemoveStmt");
 	sqlite3_bind_int (stmt, 1, id);
@@ -1122,7 +1722,7 @@ db_item_get_duplicates (const gchar *guid)
 }
 
 GSList *
-db_item_get_duplicate_nodes (const gchar *guid)
+db_item_get_duplicate_nodes (const gchar *guid, gulong id)
 {
 	GSList		*duplicates = NULL;
 	sqlite3_stmt	*stmt;
@@ -1133,11 +1733,12 @@ db_item_get_duplicate_nodes (const gchar *guid)
 	stmt = db_get_statement ("duplicateNodesFindStmt");
 	res = sqlite3_bind_text (stmt, 1, guid, -1, SQLITE_TRANSIENT);
 	if (SQLITE_OK != res)
-		g_error ("db_item_get_duplicates: sqlite bind failed (error code %d)!", res);
+		g_error ("db_item_get_duplicate_nodes: sqlite bind failed (error code %d)!", res);
+	sqlite3_bind_int (stmt, 2, id);
 
 	while (sqlite3_step (stmt) == SQLITE_ROW) 
 	{
-		gchar *id = g_strdup( sqlite3_column_text (stmt, 0));
+		gchar *id = g_strdup (db_node_id (sqlite3_column_int (stmt, 0)));
 		duplicates = g_slist_append (duplicates, id);
 	}
 
@@ -1148,6 +1749,45 @@ db_item_get_duplicate_nodes (const gchar *guid)
 	return duplicates;
 }
 
+void
+db_item_images_add (gulong id, GSList *hashes)
+{
+	sqlite3_stmt	*stmt;
+
+	if (!hashes)
+		return;
+
+	db_begin_transaction ();
+
+	stmt = db_get_statement ("itemImageInsertStmt");
+	for (; hashes; hashes = g_slist_next (hashes)) {
+		sqlite3_reset (stmt);
+		sqlite3_bind_int  (stmt, 1, id);
+		sqlite3_bind_text (stmt, 2, (const gchar *)hashes->data, -1, SQLITE_TRANSIENT);
+		if (sqlite3_step (stmt) != SQLITE_DONE)
+			g_warning ("item image insert failed (%s)", sqlite3_errmsg (db));
+	}
+	sqlite3_finalize (stmt);
+
+	db_end_transaction ();
+}
+
+GHashTable *
+db_item_images_load (void)
+{
+	GHashTable	*hashes;
+	sqlite3_stmt	*stmt;
+
+	hashes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	stmt = db_get_statement ("itemImagesLoadStmt");
+	while (sqlite3_step (stmt) == SQLITE_ROW)
+		g_hash_table_insert (hashes, g_strdup (sqlite3_column_text (stmt, 0)), GINT_TO_POINTER (1));
+	sqlite3_finalize (stmt);
+
+	return hashes;
+}
+
 void 
 db_itemset_remove_all (const gchar *id) 
 {
@@ -1155,10 +1795,13 @@ db_itemset_remove_all (const gchar *id)
 	gint		res;
 	
 	debug1(DEBUG_DB, "removing all items for item set with %s", id);
+
+	/* avoid pending state changes hitting reused item ids */
+	db_item_state_flush ();
 		
 	stmt = db_get_statement ("itemsetRemoveAllStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text (stmt, 2, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
+	sqlite3_bind_int (stmt, 2, db_node_key_lookup (id));
 	res = sqlite3_step (stmt);
 
 	if (SQLITE_DONE != res)
@@ -1168,6 +1811,87 @@ db_itemset_remove_all (const gchar *id)
 
 }
 
+/* Returns a comma separated list of the node keys of the given node ids */
+static gchar *
+db_node_key_list (GSList *ids)
+{
+	GString	*list = g_string_new (NULL);
+
+	while (ids) {
+		if (list->len)
+			g_string_append_c (list, ',');
+		g_string_append_printf (list, "%d", db_node_key_lookup ((const gchar *)ids->data));
+		ids = g_slist_next (ids);
+	}
+
+	if (!list->len)
+		g_string_append (list, "NULL");
+
+	return g_string_free (list, FALSE);
+}
+
+GHashTable *
+db_itemset_mark_read (GSList *nodeIds, GSList *searchFolderIds)
+{
+	sqlite3_stmt	*stmt;
+	GHashTable	*items;
+	gchar		*nodeKeys, *searchFolderKeys, *sql;
+
+	items = g_hash_table_new (g_direct_hash, g_direct_equal);
+	if (!nodeIds && !searchFolderIds)
+		return items;
+
+	db_item_state_flush ();
+
+	debug_start_measurement (DEBUG_DB);
+
+	/* node keys are plain integers and can be safely inlined */
+	nodeKeys = db_node_key_list (nodeIds);
+	searchFolderKeys = db_node_key_list (searchFolderIds);
+
+	db_begin_transaction ();
+
+	db_exec ("CREATE TEMP TABLE IF NOT EXISTS marked_items ("
+	         "   item_id		INTEGER PRIMARY KEY,"
+	         "   node_id		INTEGER"
+	         ");");
+	db_exec ("DELETE FROM marked_items;");
+
+	/* 1. Collect all unread items of the given nodes and search folders */
+	sql = sqlite3_mprintf ("INSERT OR IGNORE INTO marked_items SELECT item_id, node_id FROM items "
+	                       "WHERE read = 0 AND (node_id IN (%s) OR item_id IN "
+	                       "(SELECT item_id FROM search_folder_items WHERE node_id IN (%s)));",
+	                       nodeKeys, searchFolderKeys);
+	db_exec (sql);
+	sqlite3_free (sql);
+
+	/* 2. Duplicate state propagation */
+	db_exec ("INSERT OR IGNORE INTO marked_items SELECT item_id, node_id FROM items "
+	         "WHERE read = 0 AND source_id IN "
+	         "(SELECT i.source_id FROM items i JOIN marked_items m ON i.item_id = m.item_id WHERE i.valid_guid = 1);");
+
+	/* 3. Mark them all read */
+	db_exec ("UPDATE items SET read = 1, updated = 0 WHERE item_id IN (SELECT item_id FROM marked_items);");
+
+	db_prepare_stmt (&stmt, "SELECT item_id, node_id FROM marked_items");
+	while (sqlite3_step (stmt) == SQLITE_ROW) {
+		g_hash_table_insert (items, GUINT_TO_POINTER (sqlite3_column_int (stmt, 0)),
+		                     (gpointer)db_node_id (sqlite3_column_int (stmt, 1)));
+	}
+	sqlite3_finalize (stmt);
+
+	db_exec ("DELETE FROM marked_items;");
+	db_end_transaction ();
+
+	g_free (nodeKeys);
+	g_free (searchFolderKeys);
+
+	debug1 (DEBUG_DB, "marked %u items read", g_hash_table_size (items));
+	debug_end_measurement (DEBUG_DB, "mark items read");
+
+	return items;
+}
+
 void 
 db_itemset_mark_all_popup (const gchar *id) 
 {
@@ -1177,7 +1901,7 @@ db_itemset_mark_all_popup (const gchar *id)
 	debug1 (DEBUG_DB, "marking all items popup for item set with %s", id);
 		
 	stmt = db_get_statement ("itemsetMarkAllPopupStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	res = sqlite3_step (stmt);
 
 	if (SQLITE_DONE != res)
@@ -1211,17 +1935,67 @@ db_itemset_get (itemSetPtr itemSet, gulong offset, guint limit)
 
 /* Statistics interface */
 
+/* Returns how much the not yet written read states change the number
+   of unread items selected by the given FROM/WHERE clause (which must
+   name the items table "items"). This allows counting without writing
+   the pending states first, which would defeat their delayed writing
+   as every read state change triggers a recount. */
+static gint
+db_item_state_unread_delta (const gchar *selection)
+{
+	sqlite3_stmt	*stmt;
+	GHashTableIter	iter;
+	gpointer	id, value;
+	GString		*pending, *unread;
+	gchar		*sql;
+	gint		delta = 0;
+
+	if (!pendingStates || (0 == g_hash_table_size (pendingStates)))
+		return 0;
+
+	pending = g_string_new (NULL);
+	unread = g_string_new (NULL);
+
+	g_hash_table_iter_init (&iter, pendingStates);
+	while (g_hash_table_iter_next (&iter, &id, &value)) {
+		g_string_append_printf (pending, "%s%u", pending->len?",":"", GPOINTER_TO_UINT (id));
+		if (!(GPOINTER_TO_UINT (value) & DB_ITEM_STATE_READ))
+			g_string_append_printf (unread, "%s%u", unread->len?",":"", GPOINTER_TO_UINT (id));
+	}
+
+	if (!unread->len)
+		g_string_append (unread, "NULL");
+
+	/* item ids are plain integers and can be safely inlined */
+	sql = sqlite3_mprintf ("SELECT count(CASE WHEN items.item_id IN (%s) THEN 1 END) - "
+	                       "count(CASE WHEN items.read = 0 THEN 1 END) "
+	                       "%s AND items.item_id IN (%s);",
+	                       unread->str, selection, pending->str);
+	db_prepare_stmt (&stmt, sql);
+	if (SQLITE_ROW == sqlite3_step (stmt))
+		delta = sqlite3_column_int (stmt, 0);
+	else
+		g_warning ("pending read state counting failed (%s)", sqlite3_errmsg (db));
+	sqlite3_finalize (stmt);
+
+	sqlite3_free (sql);
+	g_string_free (pending, TRUE);
+	g_string_free (unread, TRUE);
+
+	return delta;
+}
+
 guint 
 db_itemset_get_unread_count (const gchar *id) 
 {
 	sqlite3_stmt	*stmt;
-	gint		res;
-	guint		count = 0;
-	
+	gchar		*selection;
+	gint		res, count = 0;
+
 	debug_start_measurement (DEBUG_DB);
 	
 	stmt = db_get_statement ("itemsetReadCountStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	res = sqlite3_step (stmt);
 	
 	if (SQLITE_ROW == res)
@@ -1231,9 +2005,13 @@ db_itemset_get_unread_count (const gchar *id)
 		
 	sqlite3_finalize (stmt);
 
+	selection = sqlite3_mprintf ("FROM items WHERE items.node_id = %d", db_node_key_lookup (id));
+	count += db_item_state_unread_delta (selection);
+	sqlite3_free (selection);
+
 	debug_end_measurement (DEBUG_DB, "counting unread items");
 
-	return count;
+	return MAX (count, 0);
 }
 
 guint 
@@ -1246,7 +2024,7 @@ db_itemset_get_item_count (const gchar *id)
 	debug_start_measurement (DEBUG_DB);
 	
 	stmt = db_get_statement ("itemsetItemCountStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	res = sqlite3_step (stmt);
 	
 	if (SQLITE_ROW == res)
@@ -1343,7 +2121,7 @@ db_search_folder_load (const gchar *id)
 	debug1 (DEBUG_DB, "loading search folder node \"%s\"", id);
 
 	stmt = db_get_statement ("searchFolderLoadStmt");
-	res = sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	res = sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	if (SQLITE_OK != res)
 		g_error ("db_search_folder_load: sqlite bind failed (error code %d)!", res);
 	
@@ -1369,7 +2147,7 @@ db_search_folder_reset (const gchar *id)
 
 	debug1 (DEBUG_DB, "resetting search folder node \"%s\"", id);
 	
-	sql = sqlite3_mprintf ("DELETE FROM search_folder_items WHERE node_id = '%s';", id);
+	sql = sqlite3_mprintf ("DELETE FROM search_folder_items WHERE node_id = %d;", db_node_key_lookup (id));
 	res = sqlite3_exec (db, sql, NULL, NULL, &err);
 	if (SQLITE_OK != res)
 		g_warning ("resetting search folder failed (%s) SQL: %s", err, sql);
@@ -1396,8 +2174,8 @@ db_search_folder_add_items (const gchar *id, GSList *items)
 		itemPtr item = (itemPtr)iter->data;
 
 		sqlite3_reset (stmt);
-		sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
-		sqlite3_bind_text (stmt, 2, item->nodeId, -1, SQLITE_TRANSIENT);
+		db_bind_node_key (stmt, 1, id);
+		db_bind_node_key (stmt, 2, item->nodeId);
 		sqlite3_bind_int (stmt, 3, item->id);
 		res = sqlite3_step (stmt);
 		if (SQLITE_DONE != res)
@@ -1412,40 +2190,105 @@ db_search_folder_add_items (const gchar *id, GSList *items)
 	debug0 (DEBUG_DB, "adding items to search folder finished");
 }
 
-guint 
-db_search_folder_get_item_count (const gchar *id) 
+void
+db_search_folder_add_item_ids (const gchar *id, GHashTable *items)
 {
 	sqlite3_stmt	*stmt;
+	GHashTableIter	iter;
+	gpointer	itemId, nodeId;
 	gint		res;
-	guint		count = 0;
-	
+
+	debug2 (DEBUG_DB, "add %d item ids to search folder node \"%s\"", g_hash_table_size (items), id);
+
+	db_begin_transaction ();
+	stmt = db_get_statement ("itemUpdateSearchFoldersStmt");
+
+	g_hash_table_iter_init (&iter, items);
+	while (g_hash_table_iter_next (&iter, &itemId, &nodeId)) {
+		sqlite3_reset (stmt);
+		db_bind_node_key (stmt, 1, id);
+		db_bind_node_key (stmt, 2, (const gchar *)nodeId);
+		sqlite3_bind_int (stmt, 3, GPOINTER_TO_UINT (itemId));
+		res = sqlite3_step (stmt);
+		if (SQLITE_DONE != res)
+			g_warning ("item add to search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+	}
+
+	sqlite3_finalize (stmt);
+	db_end_transaction ();
+}
+
+void
+db_search_folder_remove_item_ids (const gchar *id, GHashTable *items)
+{
+	sqlite3_stmt	*stmt;
+	GHashTableIter	iter;
+	gpointer	itemId;
+	gint		res;
+
+	debug2 (DEBUG_DB, "remove %d item ids from search folder node \"%s\"", g_hash_table_size (items), id);
+
+	db_begin_transaction ();
+	stmt = db_get_statement ("itemRemoveFromSearchFolderStmt");
+
+	g_hash_table_iter_init (&iter, items);
+	while (g_hash_table_iter_next (&iter, &itemId, NULL)) {
+		sqlite3_reset (stmt);
+		sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
+		sqlite3_bind_int (stmt, 2, GPOINTER_TO_UINT (itemId));
+		res = sqlite3_step (stmt);
+		if (SQLITE_DONE != res)
+			g_warning ("item remove from search folder failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+	}
+
+	sqlite3_finalize (stmt);
+	db_end_transaction ();
+}
+
+void
+db_search_folder_get_counts (const gchar *id, guint *itemCount, guint *unreadCount)
+{
+	sqlite3_stmt	*stmt;
+	gchar		*selection;
+	gint		res, unread = 0;
+
+	*itemCount = 0;
+	*unreadCount = 0;
+
 	debug_start_measurement (DEBUG_DB);
 	
 	stmt = db_get_statement ("searchFolderCountStmt");
-	sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	res = sqlite3_step (stmt);
 	
-	if (SQLITE_ROW == res)
-		count = sqlite3_column_int (stmt, 0);
-	else
-		g_warning("item read counting failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+	if (SQLITE_ROW == res) {
+		*itemCount = sqlite3_column_int (stmt, 0);
+		unread = sqlite3_column_int (stmt, 1);
+	} else {
+		g_warning("search folder item counting failed (error code=%d, %s)", res, sqlite3_errmsg (db));
+	}
 		
 	sqlite3_finalize (stmt);
 
-	debug_end_measurement (DEBUG_DB, "counting unread items");
+	selection = sqlite3_mprintf ("FROM search_folder_items INNER JOIN items ON items.item_id = search_folder_items.item_id "
+	                             "WHERE search_folder_items.node_id = %d", db_node_key_lookup (id));
+	unread += db_item_state_unread_delta (selection);
+	sqlite3_free (selection);
 
-	return count;
+	*unreadCount = MAX (unread, 0);
+
+	debug_end_measurement (DEBUG_DB, "counting search folder items");
 }
 
-static GSList *
+static metadataListPtr
 db_subscription_metadata_load(const gchar *id) 
 {
-	GSList		*metadata = NULL;
+	metadataListPtr	metadata = NULL;
 	sqlite3_stmt	*stmt;
 	gint		res;
 
 	stmt = db_get_statement ("subscriptionMetadataLoadStmt");
-	res = sqlite3_bind_text (stmt, 1, id, -1, SQLITE_TRANSIENT);
+	res = sqlite3_bind_int (stmt, 1, db_node_key_lookup (id));
 	if (SQLITE_OK != res)
 		g_error ("db_subscription_metadata_load: sqlite bind failed (error code %d)!", res);
 
@@ -1470,7 +2313,7 @@ db_subscription_metadata_update_cb (const gchar *key,
 	gint		res;
 
 	stmt = db_get_statement ("subscriptionMetadataUpdateStmt");
-	sqlite3_bind_text (stmt, 1, node->id, -1, SQLITE_TRANSIENT);
+	db_bind_node_key (stmt, 1, node->id);
 	sqlite3_bind_int  (stmt, 2, index);
 	sqlite3_bind_text (stmt, 3, key, -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text (stmt, 4, value, -1, SQLITE_TRANSIENT);
@@ -107,6 +107,18 @@ gboolean        db_itemset_get (itemSetPtr itemSet, gulong offset, guint limit);
  */
 itemPtr	db_item_load(gulong id);
 
+/**
+ * Loads the item specified by id from the DB allocating
+ * the item and its strings from the given arena.
+ *
+ * @param id		the id
+ * @param arena		the item arena (or NULL for a heap item)
+ *
+ * @returns new item structure, must be free'd using item_unload()
+ *          and not be used after the arena was free'd
+ */
+itemPtr	db_item_load_with_arena(gulong id, itemArenaPtr arena);
+
 /**
  * Updates all attributes of the item in the DB
  *
@@ -122,12 +134,22 @@ void	db_item_update(itemPtr item);
 void	db_item_remove(gulong id);
 
 /**
- * Update the attributes related to item state only.
+ * Update the attributes related to item state only. The state
+ * is written with a delay of at most one second together with
+ * other state changes (see db_item_state_flush()).
  *
  * @param item          the item
  */
 void    db_item_state_update (itemPtr item);
 
+/**
+ * Writes all pending item state changes (and descriptions stripped
+ * again after loading) to the DB in one transaction. State changes
+ * are usually written with a short delay, call this before queries
+ * depending on the item state.
+ */
+void    db_item_state_flush (void);
+
 /**
  * Returns a list of item ids with the given GUID. 
  *
@@ -138,13 +160,46 @@ void    db_item_state_update (itemPtr item);
 GSList * db_item_get_duplicates(const gchar *guid);
 
 /**
- * Returns a list of node ids containing an item with the given GUID. 
+ * Returns a list of node ids containing another item with the given
+ * GUID. Use the item duplicate count to avoid calling this for items
+ * without duplicates.
  *
  * @param guid	the item GUID
+ * @param id	id of the item not to be returned
  *
  * @returns a list of node ids (to be free'd using g_free)
  */
-GSList * db_item_get_duplicate_nodes(const gchar *guid);
+GSList * db_item_get_duplicate_nodes (const gchar *guid, gulong id);
+
+/**
+ * Records that the given item uses the given cached images.
+ * The records are removed together with the item.
+ *
+ * @param id		the item id
+ * @param hashes	list of image cache file names
+ */
+void db_item_images_add (gulong id, GSList *hashes);
+
+/**
+ * Returns the file names of all cached images still used by items.
+ *
+ * @returns a hash table with the file names as keys
+ *          (to be free'd using g_hash_table_destroy())
+ */
+GHashTable * db_item_images_load (void);
+
+/**
+ * Marks all unread items of the given nodes and search folders and
+ * all duplicates of those items as read in one transaction without
+ * loading the items.
+ *
+ * @param nodeIds		ids of the nodes whose items are to be marked
+ * @param searchFolderIds	ids of the search folders whose items are to be marked
+ *
+ * @returns hash table of the marked item ids (keys) with their 
+ *          node ids (values), to be free'd using g_hash_table_destroy()
+ */
+GHashTable * db_itemset_mark_read (GSList *nodeIds, GSList *searchFolderIds);
 
 /**
  * Returns an item set of all items for the given search folder id.
@@ -171,13 +226,30 @@ void    db_search_folder_reset (const gchar *id);
 void    db_search_folder_add_items (const gchar *id, GSList *items);
 
 /**
- * Returns the number of items for the given search folder.
+ * Add a set of item ids to a search folder.
  *
- * @param id	the node id
+ * @param id            the search folder id
+ * @param items         hash table of item ids with their node ids
+ *                      as returned by db_itemset_mark_read()
+ */
+void    db_search_folder_add_item_ids (const gchar *id, GHashTable *items);
+
+/**
+ * Remove a set of item ids from a search folder.
  *
- * @returns the number of items
+ * @param id            the search folder id
+ * @param items         hash table with item ids as keys
+ */
+void    db_search_folder_remove_item_ids (const gchar *id, GHashTable *items);
+
+/**
+ * Counts all and all unread items of the given search folder.
+ *
+ * @param id		the node id
+ * @param itemCount	returns the number of items
+ * @param unreadCount	returns the number of unread items
  */
-guint   db_search_folder_get_item_count (const gchar *id);
+void    db_search_folder_get_counts (const gchar *id, guint *itemCount, guint *unreadCount);
 
 /**
  * Load the metadata and update state of the given subscription.
@@ -29,7 +29,6 @@
 #include "common.h"
 #include "db.h"
 #include "debug.h"
-#include "favicon.h"
 #include "feedlist.h"
 #include "folder.h"
 #include "xml.h"
@@ -326,8 +325,9 @@ import_parse_outline (xmlNodePtr cur, nodePtr parentNode, gboolean trusted)
 	else 
 		node->expanded = TRUE;
 	
-	/* 3. Try to load the favicon (needs to be done before adding to the feed list) */
-	node_set_icon (node, favicon_load_from_cache (node->id));
+	/* 3. Assign the favicon (needs to be done before adding to the feed list),
+	      it is loaded from the favicon cache once the node is shown */
+	node_set_icon_deferred (node);
 			
 	/* 4. add to GUI parent */
 	feedlist_node_imported (node);
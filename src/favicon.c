@@ -68,35 +68,263 @@ favicon_download_ctxt_free (faviconDownloadCtxtPtr ctxt)
 
 static void favicon_download_run(faviconDownloadCtxtPtr ctxt);
 
-GdkPixbuf * favicon_load_from_cache(const gchar *id) {
-	struct stat	statinfo;
+/* The favicon cache file keeps all favicons pre-scaled to 16x16 RGBA
+   pixels, so that they can be loaded at startup with a single read
+   instead of decoding and scaling one PNG file per subscription. The
+   PNG files remain the master copy: each entry records the mtime and
+   size of the PNG file it was made from and is ignored once the PNG
+   file no longer matches.
+
+   File layout: the magic "LFIC", a version byte, then for each icon
+   the id length (one byte), the id, the PNG mtime (8 bytes), the PNG
+   size (4 bytes, both little endian) and the pixel data. */
+
+#define FAVICON_SIZE			16
+#define FAVICON_CACHE_MAGIC		"LFIC"
+#define FAVICON_CACHE_VERSION		2
+#define FAVICON_CACHE_ROWSTRIDE		(FAVICON_SIZE * 4)
+#define FAVICON_CACHE_PIXELS		(FAVICON_SIZE * FAVICON_CACHE_ROWSTRIDE)
+#define FAVICON_CACHE_STAT_SIZE		(sizeof (gint64) + sizeof (guint32))
+#define FAVICON_CACHE_SAVE_DELAY	5	/**< seconds to collect changes before saving */
+
+typedef struct faviconCacheEntry {
+	GdkPixbuf	*pixbuf;	/**< pre-scaled RGBA icon */
+	gint64		mtime;		/**< mtime of the PNG file the icon was made from */
+	guint32		size;		/**< size of the PNG file the icon was made from */
+} *faviconCacheEntryPtr;
+
+/** favicon id -> faviconCacheEntryPtr, NULL until first use */
+static GHashTable *faviconCache = NULL;
+
+/** timeout source id of the next cache file save */
+static guint faviconCacheSaveId = 0;
+
+static faviconCacheEntryPtr
+favicon_cache_entry_new (GdkPixbuf *pixbuf, gint64 mtime, guint32 size)
+{
+	faviconCacheEntryPtr entry = g_new0 (struct faviconCacheEntry, 1);
+
+	entry->pixbuf = pixbuf;
+	entry->mtime = mtime;
+	entry->size = size;
+
+	return entry;
+}
+
+static void
+favicon_cache_entry_free (gpointer data)
+{
+	faviconCacheEntryPtr entry = (faviconCacheEntryPtr)data;
+
+	g_object_unref (entry->pixbuf);
+	g_free (entry);
+}
+
+static gchar *
+favicon_cache_get_filename (void)
+{
+	return common_create_cache_filename ("favicons", "favicons", "cache");
+}
+
+static void
+favicon_cache_load (void)
+{
+	gchar	*filename, *data = NULL;
+	gsize	length = 0, pos;
+	guint	count = 0;
+
+	faviconCache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, favicon_cache_entry_free);
+
+	debug_start_measurement (DEBUG_CACHE);
+
+	filename = favicon_cache_get_filename ();
+	if (!g_file_get_contents (filename, &data, &length, NULL)) {
+		g_free (filename);
+		return;
+	}
+	g_free (filename);
+
+	pos = strlen (FAVICON_CACHE_MAGIC) + 1;
+	if ((length < pos) ||
+	    strncmp (data, FAVICON_CACHE_MAGIC, strlen (FAVICON_CACHE_MAGIC)) ||
+	    (FAVICON_CACHE_VERSION != (guchar)data[pos - 1])) {
+		debug0 (DEBUG_CACHE, "ignoring favicon cache file of unknown format");
+		g_free (data);
+		return;
+	}
+
+	while (pos < length) {
+		guint		idLength = (guchar)data[pos++];
+		const gchar	*stamp;
+		gint64		mtime;
+		guint32		size;
+		GdkPixbuf	*pixbuf;
+
+		if ((0 == idLength) || (pos + idLength + FAVICON_CACHE_STAT_SIZE + FAVICON_CACHE_PIXELS > length)) {
+			g_warning ("Favicon cache file is truncated!");
+			break;
+		}
+
+		stamp = data + pos + idLength;
+		memcpy (&mtime, stamp, sizeof (mtime));
+		memcpy (&size, stamp + sizeof (mtime), sizeof (size));
+
+		pixbuf = gdk_pixbuf_new_from_data (g_memdup (stamp + FAVICON_CACHE_STAT_SIZE, FAVICON_CACHE_PIXELS),
+		                                   GDK_COLORSPACE_RGB, TRUE, 8,
+		                                   FAVICON_SIZE, FAVICON_SIZE, FAVICON_CACHE_ROWSTRIDE,
+		                                   (GdkPixbufDestroyNotify)g_free, NULL);
+		g_hash_table_insert (faviconCache, g_strndup (data + pos, idLength),
+		                     favicon_cache_entry_new (pixbuf, GINT64_FROM_LE (mtime), GUINT32_FROM_LE (size)));
+		pos += idLength + FAVICON_CACHE_STAT_SIZE + FAVICON_CACHE_PIXELS;
+		count++;
+	}
+	g_free (data);
+
+	debug1 (DEBUG_CACHE, "loaded %u favicons from the favicon cache file", count);
+	debug_end_measurement (DEBUG_CACHE, "favicon cache load");
+}
+
+static gboolean
+favicon_cache_save (gpointer user_data)
+{
+	GHashTableIter	iter;
+	gpointer	id, value;
+	GString		*data;
 	gchar		*filename;
+	GError		*error = NULL;
+
+	faviconCacheSaveId = 0;
+
+	data = g_string_new (FAVICON_CACHE_MAGIC);
+	g_string_append_c (data, FAVICON_CACHE_VERSION);
+
+	g_hash_table_iter_init (&iter, faviconCache);
+	while (g_hash_table_iter_next (&iter, &id, &value)) {
+		faviconCacheEntryPtr	entry = (faviconCacheEntryPtr)value;
+		const guchar		*pixels = gdk_pixbuf_get_pixels (entry->pixbuf);
+		gint			rowstride = gdk_pixbuf_get_rowstride (entry->pixbuf);
+		gsize			idLength = strlen ((gchar *)id);
+		gint64			mtime = GINT64_TO_LE (entry->mtime);
+		guint32			size = GUINT32_TO_LE (entry->size);
+		guint			row;
+
+		if (idLength > G_MAXUINT8)
+			continue;
+
+		g_string_append_c (data, (gchar)idLength);
+		g_string_append_len (data, (gchar *)id, idLength);
+		g_string_append_len (data, (const gchar *)&mtime, sizeof (mtime));
+		g_string_append_len (data, (const gchar *)&size, sizeof (size));
+		for (row = 0; row < FAVICON_SIZE; row++)
+			g_string_append_len (data, (const gchar *)pixels + row * rowstride, FAVICON_CACHE_ROWSTRIDE);
+	}
+
+	filename = favicon_cache_get_filename ();
+	debug2 (DEBUG_CACHE, "saving %u favicons to %s", g_hash_table_size (faviconCache), filename);
+	if (!g_file_set_contents (filename, data->str, data->len, &error)) {
+		g_warning ("Could not save favicon cache file %s (%s)!", filename, error->message);
+		g_error_free (error);
+	}
+	g_free (filename);
+	g_string_free (data, TRUE);
+
+	return FALSE;
+}
+
+static void
+favicon_cache_changed (void)
+{
+	if (!faviconCacheSaveId)
+		faviconCacheSaveId = g_timeout_add_seconds (FAVICON_CACHE_SAVE_DELAY, favicon_cache_save, NULL);
+}
+
+/* Drops an icon from the favicon cache file, to be called
+   whenever its PNG file is written or removed. */
+static void
+favicon_cache_remove (const gchar *id)
+{
+	if (faviconCache && g_hash_table_remove (faviconCache, id))
+		favicon_cache_changed ();
+}
+
+static GdkPixbuf *
+favicon_load_from_file (const gchar *filename)
+{
 	GdkPixbuf	*pixbuf, *result = NULL;
 	GError 		*error = NULL;
 
+	pixbuf = gdk_pixbuf_new_from_file(filename, &error);
+	if(pixbuf) {
+		result = gdk_pixbuf_scale_simple(pixbuf, FAVICON_SIZE, FAVICON_SIZE, GDK_INTERP_BILINEAR);
+		g_object_unref(pixbuf);
+	} else { /* Error */
+		fprintf(stderr, "Failed to load pixbuf file: %s: %s\n",
+		        filename, error->message);
+		g_error_free(error);
+	}
+
+	/* the cache file only stores RGBA icons */
+	if (result && !gdk_pixbuf_get_has_alpha (result)) {
+		pixbuf = gdk_pixbuf_add_alpha (result, FALSE, 0, 0, 0);
+		g_object_unref (result);
+		result = pixbuf;
+	}
+
+	return result;
+}
+
+GdkPixbuf * favicon_load_from_cache(const gchar *id) {
+	struct stat		statinfo;
+	faviconCacheEntryPtr	entry;
+	gchar			*filename;
+	GdkPixbuf		*result = NULL;
+
 	debug_enter("favicon_load_from_cache");
-	
-	/* try to load a saved favicon */
+
+	if (!faviconCache)
+		favicon_cache_load ();
+
+	/* the PNG file is the master copy, a cache entry is only
+	   valid as long as the file it was made from is unchanged */
 	filename = common_create_cache_filename ("favicons", id, "png");
-	
-	if(0 == stat((const char*)filename, &statinfo)) {
-		pixbuf = gdk_pixbuf_new_from_file(filename, &error);
-		if(pixbuf) {
-			result = gdk_pixbuf_scale_simple(pixbuf, 16, 16, GDK_INTERP_BILINEAR);
-			g_object_unref(pixbuf);
-		} else { /* Error */
-			fprintf(stderr, "Failed to load pixbuf file: %s: %s\n",
-			        filename, error->message);
-			g_error_free(error);
+	if (0 != stat (filename, &statinfo)) {
+		favicon_cache_remove (id);
+	} else {
+		entry = g_hash_table_lookup (faviconCache, id);
+		if (entry && (entry->mtime == (gint64)statinfo.st_mtime) && (entry->size == (guint32)statinfo.st_size)) {
+			result = g_object_ref (entry->pixbuf);
+		} else {
+			result = favicon_load_from_file (filename);
+			if (result && (8 == gdk_pixbuf_get_bits_per_sample (result))) {
+				entry = favicon_cache_entry_new (g_object_ref (result), statinfo.st_mtime, statinfo.st_size);
+				g_hash_table_insert (faviconCache, g_strdup (id), entry);
+				favicon_cache_changed ();
+			} else {
+				favicon_cache_remove (id);
+			}
 		}
 	}
-	g_free(filename);	
+	g_free (filename);
 
 	debug_exit("favicon_load_from_cache");
-	
+
 	return result;
 }
 
+void
+favicon_deinit (void)
+{
+	if (faviconCacheSaveId) {
+		g_source_remove (faviconCacheSaveId);
+		favicon_cache_save (NULL);
+	}
+
+	if (faviconCache) {
+		g_hash_table_destroy (faviconCache);
+		faviconCache = NULL;
+	}
+}
+
 gboolean
 favicon_update_needed(const gchar *id, updateStatePtr updateState, GTimeVal *now)
 {
@@ -113,6 +341,8 @@ void favicon_remove_from_cache(const gchar *id) {
 	gchar		*filename;
 
 	debug_enter("favicon_remove");
+
+	favicon_cache_remove (id);
 	
 	/* try to load a saved favicon */
 	filename = common_create_cache_filename ("favicons", id, "png");
@@ -152,6 +382,7 @@ favicon_download_icon_cb (const struct updateResult * const result, gpointer use
 						g_warning ("Could not save favicon (id=%s) to file %s!", ctxt->id, tmp);
 					} else {
 						success = TRUE;
+						favicon_cache_remove (ctxt->id);
 						/* Run favicon-updated callback */
 						if (ctxt->callback)
 							(ctxt->callback) (ctxt->user_data);
@@ -74,4 +74,10 @@ typedef void (*faviconUpdatedCb)(gpointer user_data);
  */
 void favicon_download (subscriptionPtr subscription, const gchar *html_url, const gchar *source_url, const updateOptionsPtr options, faviconUpdatedCb callback, gpointer user_data);
 
+/**
+ * Saves pending changes of the favicon cache file and
+ * frees the favicon cache. To be called on shutdown.
+ */
+void favicon_deinit (void);
+
 #endif
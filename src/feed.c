@@ -166,27 +166,31 @@ feed_export (nodePtr node, xmlNodePtr xml, gboolean trusted)
 }
 
 static void
-feed_add_xml_attributes (nodePtr node, xmlNodePtr feedNode)
+feed_add_xml_attributes (nodePtr node, xmlNodePtr feedNode, GString *key)
 {
 	feedPtr	feed = (feedPtr)node->data;
 	gchar	*tmp;
 	
-	xmlNewTextChild (feedNode, NULL, "feedId", node_get_id (node));
-	xmlNewTextChild (feedNode, NULL, "feedTitle", node_get_title (node));
-
-	if (node->subscription)
-		subscription_to_xml (node->subscription, feedNode);
+	xml_add_text_child (feedNode, key, "feedId", node_get_id (node));
+	xml_add_text_child (feedNode, key, "feedTitle", node_get_title (node));
+
+	if (node->subscription) {
+		if (key)
+			subscription_to_render_key (node->subscription, key);
+		else
+			subscription_to_xml (node->subscription, feedNode);
+	}
 
 	tmp = g_strdup_printf("%d", node->available?1:0);
-	xmlNewTextChild(feedNode, NULL, "feedStatus", tmp);
+	xml_add_text_child (feedNode, key, "feedStatus", tmp);
 	g_free(tmp);
 
 	tmp = g_strdup_printf("file://%s", node_get_favicon_file (node));
-	xmlNewTextChild(feedNode, NULL, "favicon", tmp);
+	xml_add_text_child (feedNode, key, "favicon", tmp);
 	g_free(tmp);
 
 	if(feed->parseErrors && (strlen(feed->parseErrors->str) > 0))
-		xmlNewTextChild(feedNode, NULL, "parseError", feed->parseErrors->str);
+		xml_add_text_child (feedNode, key, "parseError", feed->parseErrors->str);
 }
 
 xmlDocPtr
@@ -199,11 +203,17 @@ feed_to_xml (nodePtr node, xmlNodePtr feedNode)
 		feedNode = xmlNewDocNode (doc, NULL, "feed", NULL);
 		xmlDocSetRootElement (doc, feedNode);
 	}
-	feed_add_xml_attributes (node, feedNode);
+	feed_add_xml_attributes (node, feedNode, NULL);
 	
 	return doc;
 }
 
+void
+feed_to_render_key (nodePtr node, GString *key)
+{
+	feed_add_xml_attributes (node, NULL, key);
+}
+
 guint
 feed_get_max_item_count (nodePtr node)
 {
@@ -343,10 +353,9 @@ feed_get_direction(nodePtr feed)
 		return ("ltr");
 }
 
-static gchar *
-feed_render (nodePtr node)
+static void
+feed_render (nodePtr node, GString *output)
 {
-	gchar		*output = NULL;
 	xmlDocPtr	doc;
 	renderParamPtr	params;
 	const gchar     *text_direction = NULL;
@@ -357,10 +366,8 @@ feed_render (nodePtr node)
 	render_parameter_add (params, "txtDirection='%s'", text_direction);
 
 	doc = feed_to_xml (node, NULL);
-	output = render_xml (doc, "feed", params);
+	render_xml_append (output, doc, "feed", params);
 	xmlFreeDoc (doc);
-
-	return output;
 }
 
 static gboolean
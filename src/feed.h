@@ -82,6 +82,15 @@ feedPtr feed_new(void);
  */
 xmlDocPtr feed_to_xml(nodePtr node, xmlNodePtr xml);
 
+/**
+ * Appends everything feed_to_xml() would serialize to the
+ * given render cache key.
+ *
+ * @param node		the feed node
+ * @param key		the key to append to
+ */
+void feed_to_render_key (nodePtr node, GString *key);
+
 /**
  * Returns the feed-specific maximum cache size.
  * If none is set it returns the global default 
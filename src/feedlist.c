@@ -245,17 +245,6 @@ feedlist_is_writable (void)
 	return (0 != (NODE_TYPE (node->source->root)->capabilities & NODE_CAPABILITY_ADD_CHILDS));
 }
 
-static void
-feedlist_update_node_counters (nodePtr node)
-{
-	node_update_counters (node);	/* update with parent propagation */
-
-	if (node->needsUpdate)
-		ui_node_update (node->id);
-	if (node->children)
-		node_foreach_child (node, feedlist_update_node_counters);
-}
-
 void
 feedlist_mark_all_read (nodePtr node)
 {
@@ -264,12 +253,9 @@ feedlist_mark_all_read (nodePtr node)
 
 	feedlist_reset_new_item_count ();
 
-	if (node != ROOTNODE)
-		node_mark_all_read (node);
-	else 
-		node_foreach_child (ROOTNODE, node_mark_all_read);
-		
-	feedlist_foreach (feedlist_update_node_counters);
+	/* one pass for the whole subtree, also for the root node */
+	node_mark_all_read (node);
+
 	itemview_update_all_items ();
 	itemview_update ();
 }
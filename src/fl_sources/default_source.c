@@ -58,9 +58,11 @@ default_source_import (nodePtr node)
 	backupFilename = g_strdup_printf("%s.backup", filename);
 	
 	if (g_file_test (filename, G_FILE_TEST_EXISTS)) {
+		debug_start_measurement (DEBUG_CACHE);
 		if (!import_OPML_feedlist (filename, node, FALSE, TRUE))
 			g_error ("Fatal: Feed list import failed! You might want to try to restore\n"
 			         "the feed list file %s from the backup in %s", filename, backupFilename);
+		debug_end_measurement (DEBUG_CACHE, "feed list import");
 
 		/* upon successful import create a backup copy of the feed list */
 		if (g_file_get_contents (filename, &content, &length, NULL)) {
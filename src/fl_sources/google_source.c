@@ -375,6 +375,26 @@ google_source_item_mark_read (nodePtr node, itemPtr item, gboolean newStatus)
 	item_read_state_changed (item, newStatus);
 }
 
+static void
+google_source_items_mark_read (nodePtr node, GSList *items)
+{
+	GoogleSourcePtr	gsource = (GoogleSourcePtr) node->data;
+
+	/* Edits are queued and processed by google_source_edit_process() */
+	while (items) {
+		itemPtr		item = (itemPtr)items->data;
+		nodePtr		feed = node_from_id (item->nodeId);
+		const gchar	*sourceUrl = metadata_list_get (item->metadata, "GoogleBroadcastOrigFeed");
+
+		if (!sourceUrl && feed)
+			sourceUrl = feed->subscription->source;
+		if (sourceUrl)
+			google_source_edit_mark_read (gsource, item->sourceId, sourceUrl, TRUE);
+
+		items = g_slist_next (items);
+	}
+}
+
 /* node source type definition */
 
 static struct nodeSourceType nst = {
@@ -398,6 +418,7 @@ static struct nodeSourceType nst = {
 	.free                = google_source_cleanup,
 	.item_set_flag       = google_source_item_set_flag,
 	.item_mark_read      = google_source_item_mark_read,
+	.items_mark_read     = google_source_items_mark_read,
 	.add_folder          = NULL, 
 	.add_subscription    = google_source_add_subscription,
 	.remove_node         = google_source_remove_node
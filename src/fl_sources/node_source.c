@@ -342,6 +342,29 @@ node_source_item_mark_read (nodePtr node, itemPtr item, gboolean newState)
 		item_read_state_changed (item, newState);
 }
 
+void
+node_source_items_mark_read (nodePtr node, GSList *items)
+{
+	if (!items || !(NODE_SOURCE_TYPE (node)->capabilities & NODE_SOURCE_CAPABILITY_ITEM_STATE_SYNC))
+		return;
+
+	if (NODE_SOURCE_TYPE (node)->items_mark_read) {
+		NODE_SOURCE_TYPE (node)->items_mark_read (node, items);
+		return;
+	}
+
+	/* Fallback for implementations only supporting single items */
+	if (NODE_SOURCE_TYPE (node)->item_mark_read) {
+		while (items) {
+			itemPtr item = (itemPtr)items->data;
+			nodePtr itemNode = node_from_id (item->nodeId);
+			if (itemNode)
+				NODE_SOURCE_TYPE (node)->item_mark_read (itemNode, item, TRUE);
+			items = g_slist_next (items);
+		}
+	}
+}
+
 void
 node_source_item_set_flag (nodePtr node, itemPtr item, gboolean newState)
 {
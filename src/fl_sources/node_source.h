@@ -173,6 +173,18 @@ typedef struct nodeSourceType {
 	 */
 	void		(*remove_node) (nodePtr node, nodePtr child);
 
+	/**
+	 * Synchronizes the read state of a list of items that were
+	 * already marked as read locally. This is to allow node source
+	 * type implementations to sync bulk state changes in as few
+	 * remote requests as possible. The items may belong to any
+	 * child node of the node source.
+	 *
+	 * This is an OPTIONAL method. Should be implemented when
+	 * NODE_SOURCE_CAPABILITY_ITEM_STATE_SYNC is set.
+	 */
+	void		(*items_mark_read) (nodePtr node, GSList *items);
+
 } *nodeSourceTypePtr;
 
 /** feed list source instance */
@@ -267,6 +279,16 @@ nodePtr node_source_add_folder (nodePtr node, const gchar *title);
  */
 void node_source_item_mark_read (nodePtr node, itemPtr item, gboolean newState);
 
+/**
+ * Called when a list of items was marked read in bulk. Allows
+ * node sources with NODE_SOURCE_CAPABILITY_ITEM_STATE_SYNC
+ * to sync the new state with a single remote request.
+ *
+ * @param node		the source root node
+ * @param items		list of the affected items
+ */
+void node_source_items_mark_read (nodePtr node, GSList *items);
+
 /**
  * Called when the flag state of an item changes.
  *
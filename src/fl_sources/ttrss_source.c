@@ -353,6 +353,37 @@ ttrss_source_item_mark_read (nodePtr node, itemPtr item, gboolean newStatus)
 	item_read_state_changed (item, newStatus);
 }
 
+static void
+ttrss_source_items_mark_read (nodePtr node, GSList *items)
+{
+	ttrssSourcePtr		source = (ttrssSourcePtr)node->data;
+	updateRequestPtr	request;
+	GString			*ids;
+
+	/* The tt-rss API accepts a comma separated list of article ids */
+	ids = g_string_new (NULL);
+	while (items) {
+		itemPtr item = (itemPtr)items->data;
+		if (item_get_id (item)) {
+			if (ids->len)
+				g_string_append_c (ids, ',');
+			g_string_append (ids, item_get_id (item));
+		}
+		items = g_slist_next (items);
+	}
+
+	if (ids->len) {
+		request = update_request_new ();
+		request->options = update_options_copy (node->subscription->updateOptions);
+		request->postdata = g_strdup_printf (TTRSS_JSON_UPDATE_ITEM_UNREAD, source->session_id, ids->str, 0);
+
+		update_request_set_source (request, g_strdup_printf (TTRSS_URL, metadata_list_get (node->subscription->metadata, "ttrss-url")));
+		update_execute_request (source, request, ttrss_source_remote_update_cb, source, 0 /* flags */);
+	}
+
+	g_string_free (ids, TRUE);
+}
+
 /* node source type definition */
 
 static struct nodeSourceType nst = {
@@ -374,6 +405,7 @@ static struct nodeSourceType nst = {
 	.free                = ttrss_source_cleanup,
 	.item_set_flag       = ttrss_source_item_set_flag,
 	.item_mark_read      = ttrss_source_item_mark_read,
+	.items_mark_read     = ttrss_source_items_mark_read,
 	.add_folder          = NULL,	/* not supported by current tt-rss JSON API (v1.5) */
 	.add_subscription    = NULL,	/* not supported by current tt-rss JSON API (v1.5) */
 	.remove_node         = NULL	/* not supported by current tt-rss JSON API (v1.5) */
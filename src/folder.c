@@ -88,6 +88,10 @@ folder_add_child_update_counters (nodePtr node, gpointer user_data)
 {
 	guint	*unreadCount = (guint *)user_data;
 
+	/* search folders only show copies of items */
+	if (IS_VFOLDER (node))
+		return;
+
 	*unreadCount += node->unreadCount;
 }
 
@@ -42,6 +42,15 @@ static struct htmlView_priv
 	GSList		*orderedChunks;	/**< ordered list of chunks */
 	nodePtr		node;		/**< the node whose items are displayed */
 	guint		missingContent;	/**< counter for items without content */
+
+	LifereaHtmlView	*patchView;	/**< HTML view showing all chunks (or NULL), see htmlview_patch() */
+	guint		patchDocument;	/**< document id of the HTML view showing all chunks */
+	gboolean	patchSummary;	/**< summary mode of the HTML view showing all chunks */
+	gboolean	patchWindowed;	/**< windowed mode of the HTML view showing all chunks */
+	GSList		*removedIds;	/**< ids of removed items still to be removed from the HTML view */
+
+	gboolean	windowed;	/**< TRUE if only items near the visible area are rendered */
+	guint		placeholderHeight; /**< estimated height of items not yet rendered */
 } htmlView_priv;
 
 typedef struct htmlChunk 
@@ -49,8 +58,160 @@ typedef struct htmlChunk
 	gulong 		id;	/**< item id */
 	gchar		*html;	/**< the rendered HTML (or NULL if not yet rendered) */
 	time_t		date;	/**< date as sorting criteria */
+	gboolean	shown;	/**< TRUE if the HTML view shows the current HTML (or placeholder) */
+	gboolean	requested; /**< TRUE if the chunk is to be rendered in windowed mode */
 } *htmlChunkPtr;
 
+/* Combined views of many items are windowed: only the first items
+   are rendered, all others get placeholders. When scrolling near a
+   placeholder the page requests the item using htmlview_load_items()
+   which then replaces the placeholder using htmlview_patch(). */
+#define WINDOWED_MIN_ITEMS	100	/**< minimum number of items for windowed rendering */
+#define WINDOWED_INITIAL_ITEMS	20	/**< number of items rendered immediately */
+
+/* Rendered item HTML is additionally kept in a cache that survives
+   switching between nodes. Entries are keyed by a digest of all item
+   and feed properties the rendering depends on and the rendering
+   parameters, so any change of the item, its feed or the rendering
+   options results in a new key and outdated entries simply age out.
+   The key is computed without serializing the item, so cache hits
+   neither need the XSLT input document. */
+
+#define RENDER_CACHE_MAX_SIZE	(8 * 1024 * 1024)	/**< maximum size of all cached HTML in bytes */
+
+typedef struct renderCacheEntry
+{
+	gchar		*key;	/**< digest of the rendering input */
+	gchar		*html;	/**< the rendered HTML */
+	gsize		size;	/**< size of the HTML in bytes */
+	GList		*link;	/**< link in the LRU queue */
+	gboolean	prefetched; /**< TRUE if rendered by htmlview_prefetch_item() and not yet used */
+} *renderCacheEntryPtr;
+
+static struct renderCache
+{
+	GHashTable	*entries;	/**< key -> renderCacheEntryPtr */
+	GQueue		*lru;		/**< entries, most recently used first */
+	gsize		size;		/**< size of all cached HTML in bytes */
+
+	gboolean	prefetching;	/**< TRUE while htmlview_prefetch_item() is running */
+	guint		prefetchCount;	/**< number of prefetched items (for debugging) */
+	guint		prefetchHits;	/**< number of prefetched items that were used (for debugging) */
+} renderCache;
+
+static void
+htmlview_render_cache_entry_free (gpointer data)
+{
+	renderCacheEntryPtr entry = (renderCacheEntryPtr)data;
+
+	renderCache.size -= entry->size;
+	g_queue_delete_link (renderCache.lru, entry->link);
+	g_free (entry->key);
+	g_free (entry->html);
+	g_free (entry);
+}
+
+static const gchar *
+htmlview_render_cache_lookup (const gchar *key)
+{
+	renderCacheEntryPtr	entry;
+
+	if (!key || !renderCache.entries)
+		return NULL;
+
+	entry = g_hash_table_lookup (renderCache.entries, key);
+	if (!entry)
+		return NULL;
+
+	/* move to the front of the LRU queue */
+	g_queue_unlink (renderCache.lru, entry->link);
+	g_queue_push_head_link (renderCache.lru, entry->link);
+
+	if (entry->prefetched && !renderCache.prefetching) {
+		entry->prefetched = FALSE;
+		renderCache.prefetchHits++;
+		debug2 (DEBUG_HTML, "prefetch hit rate: %u of %u prefetched items used",
+		        renderCache.prefetchHits, renderCache.prefetchCount);
+	}
+
+	return entry->html;
+}
+
+static void
+htmlview_render_cache_add (const gchar *key, const gchar *html, gboolean prefetched)
+{
+	renderCacheEntryPtr	entry;
+
+	if (!key)
+		return;
+
+	if (!renderCache.entries) {
+		renderCache.entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, htmlview_render_cache_entry_free);
+		renderCache.lru = g_queue_new ();
+	}
+
+	entry = g_new0 (struct renderCacheEntry, 1);
+	entry->key = g_strdup (key);
+	entry->html = g_strdup (html);
+	entry->size = strlen (html) + 1;
+	entry->prefetched = prefetched;
+	if (entry->size > RENDER_CACHE_MAX_SIZE / 4) {
+		g_free (entry->key);
+		g_free (entry->html);
+		g_free (entry);
+		return;
+	}
+
+	g_queue_push_head (renderCache.lru, entry);
+	entry->link = g_queue_peek_head_link (renderCache.lru);
+	renderCache.size += entry->size;
+	g_hash_table_replace (renderCache.entries, entry->key, entry);
+
+	/* drop the least recently used entries */
+	while (renderCache.size > RENDER_CACHE_MAX_SIZE) {
+		renderCacheEntryPtr oldest = g_queue_peek_tail (renderCache.lru);
+		g_hash_table_remove (renderCache.entries, oldest->key);
+	}
+}
+
+/**
+ * Computes the render cache key for the given item. The key is built
+ * by the same serialization code as the XML document to be rendered
+ * (see item_to_render_key()), so it covers everything the rendering
+ * depends on.
+ *
+ * @param item		the item to render
+ * @param node		the node the item belongs to
+ * @param params	the rendering parameters
+ *
+ * @returns a new key string or NULL if the item is not to be cached
+ */
+static gchar *
+htmlview_render_cache_key (itemPtr item, nodePtr node, renderParamPtr params)
+{
+	GString	*data;
+	gchar	*key;
+	guint	i;
+
+	data = g_string_sized_new (4096);
+
+	if (!item_to_render_key (item, data)) {
+		g_string_free (data, TRUE);
+		return NULL;
+	}
+
+	if (IS_FEED (node))
+		feed_to_render_key (node, data);
+
+	for (i = 0; i < params->len; i++)
+		g_string_append_len (data, params->params[i], strlen (params->params[i]) + 1);
+
+	key = g_compute_checksum_for_data (G_CHECKSUM_SHA1, (const guchar *)data->str, data->len);
+	g_string_free (data, TRUE);
+
+	return key;
+}
+
 static void
 htmlview_chunk_free (htmlChunkPtr chunk) 
 {
@@ -92,6 +253,11 @@ htmlview_clear (void)
 	htmlView_priv.chunkHash = g_hash_table_new (g_direct_hash, g_direct_equal);
 	htmlView_priv.orderedChunks = NULL;
 	htmlView_priv.missingContent = 0;
+
+	g_slist_free (htmlView_priv.removedIds);
+	htmlView_priv.removedIds = NULL;
+	htmlView_priv.patchView = NULL;
+	htmlView_priv.windowed = FALSE;
 }
 
 void
@@ -131,6 +297,9 @@ htmlview_remove_item (itemPtr item)
 		g_hash_table_remove (htmlView_priv.chunkHash, GUINT_TO_POINTER (item->id));
 		htmlView_priv.orderedChunks = g_slist_remove (htmlView_priv.orderedChunks, chunk);
 		htmlview_chunk_free (chunk);
+
+		if (htmlView_priv.patchView)
+			htmlView_priv.removedIds = g_slist_prepend (htmlView_priv.removedIds, GUINT_TO_POINTER (item->id));
 	}
 }
 
@@ -152,6 +321,7 @@ htmlview_update_item (itemPtr item)
 	{
 		g_free (chunk->html);
 		chunk->html = NULL;
+		chunk->shown = FALSE;
 	}
 }
 
@@ -163,6 +333,7 @@ htmlview_update_all_items (void)
 		htmlChunkPtr chunk = (htmlChunkPtr)iter->data;
 		g_free (chunk->html);
 		chunk->html = NULL;
+		chunk->shown = FALSE;
 		iter = g_slist_next (iter);
 	}
 }
@@ -180,20 +351,29 @@ htmlview_get_item_direction(itemPtr item)
 	return ("ltr");
 }
 
+/**
+ * Prepares the rendering of the given item. Returns the HTML from
+ * the render cache if possible. Otherwise the XSLT input document,
+ * the rendering parameters and the render cache key (NULL if the
+ * item is not to be cached) are returned.
+ *
+ * @returns rendered HTML or NULL if rendering is needed
+ */
 static gchar *
-htmlview_render_item (itemPtr item, 
-                      guint viewMode,
-                      gboolean summaryMode) 
+htmlview_prepare_item (itemPtr item, 
+                       guint viewMode,
+                       gboolean summaryMode,
+                       xmlDocPtr *doc,
+                       renderParamPtr *params,
+                       gchar **key) 
 {
-	renderParamPtr	params;
-	gchar		*output = NULL, *baseUrl = NULL;
+	gchar		*baseUrl = NULL;
+	const gchar	*cached;
 	nodePtr		node;
-	xmlDocPtr 	doc;
 	xmlNodePtr 	xmlNode;
-	const gchar     *text_direction = NULL;
 	gboolean	isMergedItemset;
 
-	debug_enter ("htmlview_render_item");
+	*doc = NULL;
 
 	/* don't use node from htmlView_priv as this would be
 	   wrong for folders and other merged item sets */
@@ -201,45 +381,188 @@ htmlview_render_item (itemPtr item,
 	
 	isMergedItemset = (node != htmlView_priv.node);
 
+	/* prepare the XSLT rendering */
+	*params = render_parameter_new ();
+	
+	if (NULL != node_get_base_url (node)) {
+		baseUrl = common_uri_escape (node_get_base_url (node));
+		render_parameter_add (*params, "baseUrl='%s'", baseUrl);
+	}
+	
+	render_parameter_add (*params, "summary='%d'", summaryMode?1:0);
+	render_parameter_add (*params, "showFeedName='%d'", isMergedItemset?1:0);
+	render_parameter_add (*params, "single='%d'", (viewMode == ITEMVIEW_SINGLE_ITEM)?1:0);
+	render_parameter_add (*params, "txtDirection='%s'", htmlview_get_item_direction (item));
+	render_parameter_add (*params, "appDirection='%s'", common_get_app_direction ());
+	g_free (baseUrl);
+
+	*key = htmlview_render_cache_key (item, node, *params);
+	cached = htmlview_render_cache_lookup (*key);
+	if (cached) {
+		debug1 (DEBUG_HTML, "using cached HTML for item %lu", item->id);
+		render_parameter_free (*params);
+		g_free (*key);
+		*params = NULL;
+		*key = NULL;
+		return g_strdup (cached);
+	}
+
 	/* do the XML serialization */
-	doc = xmlNewDoc ("1.0");
-	xmlNode = xmlNewDocNode (doc, NULL, "itemset", NULL);
-	xmlDocSetRootElement (doc, xmlNode);
+	*doc = xmlNewDoc ("1.0");
+	xmlNode = xmlNewDocNode (*doc, NULL, "itemset", NULL);
+	xmlDocSetRootElement (*doc, xmlNode);
 				
-	item_to_xml(item, xmlDocGetRootElement (doc));
-
-	text_direction = htmlview_get_item_direction (item);
+	item_to_xml(item, xmlDocGetRootElement (*doc));
 			
 	if (IS_FEED (node)) {
 		xmlNodePtr feed;
-		feed = xmlNewChild (xmlDocGetRootElement (doc), NULL, "feed", NULL);
+		feed = xmlNewChild (xmlDocGetRootElement (*doc), NULL, "feed", NULL);
 		feed_to_xml (node, feed);
 	}
-	
-	/* do the XSLT rendering */
-	params = render_parameter_new ();
-	
-	if (NULL != node_get_base_url (node)) {
-		baseUrl = common_uri_escape (node_get_base_url (node));
-		render_parameter_add (params, "baseUrl='%s'", baseUrl);
+
+	/* For debugging use: xmlSaveFormatFile("/tmp/test.xml", *doc, 1); */
+
+	return NULL;
+}
+
+static gchar *
+htmlview_render_item (itemPtr item, 
+                      guint viewMode,
+                      gboolean summaryMode) 
+{
+	renderParamPtr	params;
+	gchar		*output, *key;
+	xmlDocPtr 	doc;
+
+	debug_enter ("htmlview_render_item");
+
+	output = htmlview_prepare_item (item, viewMode, summaryMode, &doc, &params, &key);
+	if (!output) {
+		/* do the XSLT rendering */
+		output = render_xml (doc, "item", params);
+		if (output)
+			htmlview_render_cache_add (key, output, FALSE);
+		xmlFreeDoc (doc);
+		g_free (key);
 	}
 	
-	render_parameter_add (params, "summary='%d'", summaryMode?1:0);
-	render_parameter_add (params, "showFeedName='%d'", isMergedItemset?1:0);
-	render_parameter_add (params, "single='%d'", (viewMode == ITEMVIEW_SINGLE_ITEM)?1:0);
-	render_parameter_add (params, "txtDirection='%s'", text_direction);
-	render_parameter_add (params, "appDirection='%s'", common_get_app_direction ());
-	output = render_xml (doc, "item", params);
-	
-	/* For debugging use: xmlSaveFormatFile("/tmp/test.xml", doc, 1); */
-	xmlFreeDoc (doc);
-	g_free (baseUrl);
-	
 	debug_exit ("htmlview_render_item");
 
 	return output;
 }
 
+void
+htmlview_prefetch_item (itemPtr item)
+{
+	renderParamPtr	params;
+	gchar		*output, *key;
+	xmlDocPtr 	doc;
+	nodePtr		node;
+	gboolean	readStatus, updateStatus;
+
+	/* items whose link is loaded are not rendered */
+	node = node_from_id (item->nodeId);
+	if (!node || node->loadItemLink)
+		return;
+
+	/* Render the item as it will look like when being selected,
+	   which is without the unread and updated state. */
+	readStatus = item->readStatus;
+	updateStatus = item->updateStatus;
+	item->readStatus = TRUE;
+	item->updateStatus = FALSE;
+
+	renderCache.prefetching = TRUE;
+	output = htmlview_prepare_item (item, ITEMVIEW_SINGLE_ITEM, FALSE, &doc, &params, &key);
+	renderCache.prefetching = FALSE;
+
+	item->readStatus = readStatus;
+	item->updateStatus = updateStatus;
+
+	if (output) {
+		/* already rendered */
+		g_free (output);
+		return;
+	}
+
+	debug1 (DEBUG_HTML, "prefetching item \"%s\"", item_get_title (item));
+	output = render_xml (doc, "item", params);
+	if (output) {
+		htmlview_render_cache_add (key, output, TRUE);
+		renderCache.prefetchCount++;
+	}
+	xmlFreeDoc (doc);
+	g_free (key);
+	g_free (output);
+}
+
+/**
+ * Renders all items of the combined view that are not yet rendered.
+ * The input documents are prepared one after another (as this needs
+ * the database), the XSLT transformations of larger sets are done
+ * in parallel (see render_xml_parallel()).
+ */
+static void
+htmlview_render_chunks (guint viewMode, gboolean summaryMode)
+{
+	GPtrArray	*chunks, *docs, *params, *keys;
+	GSList		*iter;
+	gchar		**outputs;
+	guint		i;
+
+	chunks = g_ptr_array_new ();
+	docs = g_ptr_array_new ();
+	params = g_ptr_array_new ();
+	keys = g_ptr_array_new_with_free_func (g_free);
+
+	for (iter = htmlView_priv.orderedChunks; iter; iter = g_slist_next (iter)) {
+		htmlChunkPtr	chunk = (htmlChunkPtr)iter->data;
+		itemPtr		item;
+		xmlDocPtr	doc;
+		renderParamPtr	param;
+		gchar		*key;
+
+		if (chunk->html)
+			continue;
+
+		if (htmlView_priv.windowed && !chunk->requested)
+			continue;
+
+		item = item_load (chunk->id);
+		if (!item)
+			continue;
+
+		debug1 (DEBUG_HTML, "rendering item to HTML view: >>>%s<<<", item_get_title (item));
+		chunk->html = htmlview_prepare_item (item, viewMode, summaryMode, &doc, &param, &key);
+		if (!chunk->html) {
+			g_ptr_array_add (chunks, chunk);
+			g_ptr_array_add (docs, doc);
+			g_ptr_array_add (params, param);
+			g_ptr_array_add (keys, key);
+		}
+		item_unload (item);
+	}
+
+	if (docs->len) {
+		debug1 (DEBUG_HTML, "rendering %u items", docs->len);
+		outputs = render_xml_parallel ((xmlDocPtr *)docs->pdata, (renderParamPtr *)params->pdata, docs->len, "item");
+		for (i = 0; i < docs->len; i++) {
+			htmlChunkPtr chunk = g_ptr_array_index (chunks, i);
+
+			chunk->html = outputs[i];
+			if (chunk->html)
+				htmlview_render_cache_add (g_ptr_array_index (keys, i), chunk->html, FALSE);
+			xmlFreeDoc (g_ptr_array_index (docs, i));
+		}
+		g_free (outputs);
+	}
+
+	g_ptr_array_free (chunks, TRUE);
+	g_ptr_array_free (docs, TRUE);
+	g_ptr_array_free (params, TRUE);
+	g_ptr_array_free (keys, TRUE);
+}
+
 void 
 htmlview_start_output (GString *buffer,
                        const gchar *base,
@@ -299,6 +622,61 @@ htmlview_start_output (GString *buffer,
 		""
 		"	window.clearTimeout(popupTimeout);"
 		"}"
+		""
+		/* used by htmlview_patch(), as this is XHTML a '<' must be written as '\x3c' */
+		"/* update single items */"
+		"function lifereaRemoveItem(id) {"
+		""
+		"	var obj = document.getElementById('liferea-item-' + id);"
+		"	if(obj)"
+		"		obj.parentNode.removeChild(obj);"
+		"}"
+		""
+		"function lifereaSetItem(id, nextId, html) {"
+		""
+		"	var doc = new DOMParser().parseFromString('\\x3cdiv xmlns=\"http://www.w3.org/1999/xhtml\">' + html + '\\x3c/div>', 'application/xhtml+xml');"
+		"	if(!doc.documentElement.firstElementChild)"
+		"		return;"
+		"	var obj = document.importNode(doc.documentElement.firstElementChild, true);"
+		"	var old = document.getElementById('liferea-item-' + id);"
+		"	var next = nextId?document.getElementById('liferea-item-' + nextId):null;"
+		"	if(old)"
+		"		old.parentNode.replaceChild(obj, old);"
+		"	else if(next)"
+		"		next.parentNode.insertBefore(obj, next);"
+		"	else"
+		"		document.documentElement.appendChild(obj);"
+		"}"
+		""
+		"/* request placeholders near the visible area using htmlview_load_items() */"
+		"var lifereaLoadTimeout;"
+		""
+		"function lifereaLoadItems() {"
+		""
+		"	lifereaLoadTimeout = null;"
+		"	var margin = window.innerHeight;"
+		"	var list = document.getElementsByClassName('liferea-placeholder');"
+		"	var ids = [];"
+		"	for(var i = 0; list.length > i; i++) {"
+		"		var rect = list[i].getBoundingClientRect();"
+		"		if(list[i].getAttribute('data-requested') || -margin > rect.bottom || rect.top > window.innerHeight + margin)"
+		"			continue;"
+		"		list[i].setAttribute('data-requested', '1');"
+		"		ids.push(list[i].id.substr(13));"
+		"	}"
+		"	if(ids.length)"
+		"		console.log('liferea-load-items:' + ids.join(','));"
+		"}"
+		""
+		"function lifereaScheduleLoadItems() {"
+		""
+		"	if(!lifereaLoadTimeout)"
+		"		lifereaLoadTimeout = window.setTimeout(lifereaLoadItems, 100);"
+		"}"
+		""
+		"window.addEventListener('scroll', lifereaScheduleLoadItems, false);"
+		"window.addEventListener('resize', lifereaScheduleLoadItems, false);"
+		"window.addEventListener('load', lifereaScheduleLoadItems, false);"
 		"</script>");
 	}
 	
@@ -311,6 +689,186 @@ htmlview_finish_output (GString *buffer)
 	g_string_append (buffer, "</html>"); 
 }
 
+/* Appends the HTML of a chunk with the id needed to patch it later */
+static void
+htmlview_append_chunk (GString *buffer, htmlChunkPtr chunk)
+{
+	if (!chunk->html) {
+		g_string_append_printf (buffer, "<div id=\"liferea-item-%lu\" class=\"liferea-placeholder\" style=\"height:%upx\"></div>",
+		                        chunk->id, htmlView_priv.placeholderHeight);
+	} else if (g_str_has_prefix (chunk->html, "<body")) {
+		g_string_append_printf (buffer, "<body id=\"liferea-item-%lu\"", chunk->id);
+		g_string_append (buffer, chunk->html + strlen ("<body"));
+	} else {
+		g_string_append_printf (buffer, "<div id=\"liferea-item-%lu\">", chunk->id);
+		g_string_append (buffer, chunk->html);
+		g_string_append (buffer, "</div>");
+	}
+}
+
+/* Appends the given text as a JavaScript string literal */
+static void
+htmlview_append_js_string (GString *buffer, const gchar *text)
+{
+	const gchar *p;
+
+	g_string_append_c (buffer, '\'');
+	for (p = text; *p; p++) {
+		switch (*p) {
+			case '\\':
+			case '\'':
+				g_string_append_c (buffer, '\\');
+				g_string_append_c (buffer, *p);
+				break;
+			case '\n':
+				g_string_append (buffer, "\\n");
+				break;
+			case '\r':
+				g_string_append (buffer, "\\r");
+				break;
+			default:
+				/* U+2028 and U+2029 terminate lines in JavaScript */
+				if (!strncmp (p, "\xe2\x80\xa8", 3) || !strncmp (p, "\xe2\x80\xa9", 3)) {
+					g_string_append_printf (buffer, "\\u%04x", ((guchar)p[2] == 0xa8)?0x2028:0x2029);
+					p += 2;
+				} else {
+					g_string_append_c (buffer, *p);
+				}
+				break;
+		}
+	}
+	g_string_append_c (buffer, '\'');
+}
+
+/**
+ * Tries to update the combined view of all items displayed by the
+ * given HTML view without reloading it. Added, removed and changed
+ * items are patched into the document using JavaScript, so the
+ * scroll position and the layout of all other items are kept.
+ *
+ * @returns FALSE if the HTML view needs to be reloaded
+ */
+static gboolean
+htmlview_patch (LifereaHtmlView *htmlview, gboolean summaryMode)
+{
+	GSList		*iter, *reversed, *patched = NULL;
+	GString		*script;
+	gulong		nextId = 0;
+	guint		count = 0, total = 0;
+	gboolean	success;
+
+	if ((htmlView_priv.patchView != htmlview) ||
+	    (htmlView_priv.patchSummary != summaryMode) ||
+	    (htmlView_priv.patchWindowed != htmlView_priv.windowed))
+		return FALSE;
+
+	script = g_string_new (NULL);
+
+	for (iter = htmlView_priv.removedIds; iter; iter = g_slist_next (iter))
+		g_string_append_printf (script, "lifereaRemoveItem(%lu);", (gulong)GPOINTER_TO_UINT (iter->data));
+
+	/* Go backwards, so each new item can be inserted before its
+	   already present successor */
+	reversed = g_slist_reverse (g_slist_copy (htmlView_priv.orderedChunks));
+	for (iter = reversed; iter; iter = g_slist_next (iter)) {
+		htmlChunkPtr chunk = (htmlChunkPtr)iter->data;
+
+		total++;
+		if (!chunk->html && !htmlView_priv.windowed)
+			continue;
+
+		if (!chunk->shown) {
+			GString	*html = g_string_new (NULL);
+
+			htmlview_append_chunk (html, chunk);
+			g_string_append_printf (script, "lifereaSetItem(%lu,%lu,", chunk->id, nextId);
+			htmlview_append_js_string (script, html->str);
+			g_string_append (script, ");");
+			g_string_free (html, TRUE);
+
+			patched = g_slist_prepend (patched, chunk);
+			count++;
+		}
+		nextId = chunk->id;
+	}
+	g_slist_free (reversed);
+
+	/* Reloading is faster when most of the items changed */
+	if (count > 1 && count > total / 2) {
+		success = FALSE;
+	} else if (0 == script->len) {
+		success = TRUE;
+	} else {
+		/* replaced placeholders might uncover further ones */
+		if (htmlView_priv.windowed)
+			g_string_append (script, "lifereaScheduleLoadItems();");
+
+		debug2 (DEBUG_HTML, "patching HTML view: %u items changed, %u removed", count, g_slist_length (htmlView_priv.removedIds));
+		success = liferea_htmlview_execute_script (htmlview, htmlView_priv.patchDocument, script->str);
+	}
+
+	if (success) {
+		for (iter = patched; iter; iter = g_slist_next (iter))
+			((htmlChunkPtr)iter->data)->shown = TRUE;
+		g_slist_free (htmlView_priv.removedIds);
+		htmlView_priv.removedIds = NULL;
+	}
+
+	g_slist_free (patched);
+	g_string_free (script, TRUE);
+
+	return success;
+}
+
+/* Decides wether the combined view is to be windowed */
+static void
+htmlview_update_window (LifereaHtmlView *htmlview, gboolean summaryMode)
+{
+	GSList	*iter;
+	guint	i;
+
+	htmlView_priv.windowed = (g_hash_table_size (htmlView_priv.chunkHash) >= WINDOWED_MIN_ITEMS) &&
+	                         liferea_htmlview_scripts_enabled (htmlview);
+	htmlView_priv.placeholderHeight = summaryMode?40:200;
+
+	if (!htmlView_priv.windowed)
+		return;
+
+	for (iter = htmlView_priv.orderedChunks, i = 0; iter && (i < WINDOWED_INITIAL_ITEMS); iter = g_slist_next (iter), i++)
+		((htmlChunkPtr)iter->data)->requested = TRUE;
+}
+
+void
+htmlview_load_items (LifereaHtmlView *htmlview, const gchar *ids)
+{
+	gchar	**list;
+	guint	i;
+
+	if (!htmlView_priv.windowed || (htmlView_priv.patchView != htmlview))
+		return;
+
+	list = g_strsplit (ids, ",", 0);
+	for (i = 0; list[i]; i++) {
+		/* unknown ids are ignored, so the page can request nothing else */
+		htmlChunkPtr chunk = g_hash_table_lookup (htmlView_priv.chunkHash, GUINT_TO_POINTER (strtoul (list[i], NULL, 10)));
+		if (chunk && !chunk->requested) {
+			chunk->requested = TRUE;
+			if (!chunk->html)
+				chunk->shown = FALSE;
+		}
+	}
+	g_strfreev (list);
+
+	htmlview_render_chunks (ITEMVIEW_ALL_ITEMS, htmlView_priv.patchSummary);
+
+	/* The page marked the placeholders as requested and won't ask
+	   again, so when patching fails they have to be reloaded */
+	if (!htmlview_patch (htmlview, htmlView_priv.patchSummary)) {
+		debug0 (DEBUG_HTML, "could not add requested items to HTML view, reloading it");
+		htmlview_update (htmlview, ITEMVIEW_ALL_ITEMS);
+	}
+}
+
 void
 htmlview_update (LifereaHtmlView *htmlview, itemViewMode mode) 
 {
@@ -320,6 +878,27 @@ htmlview_update (LifereaHtmlView *htmlview, itemViewMode mode)
 	gchar		*baseURL = NULL;
 	gboolean	summaryMode;
 
+	/* Output optimization for feeds without item content. This
+	   is not done for folders, because we only support all items
+	   in summary mode or all in detailed mode. With folder item 
+	   sets displaying everything in summary because of only a
+	   single feed without item descriptions would make no sense. */
+	summaryMode = (NULL != htmlView_priv.node) &&
+	              !IS_FOLDER (htmlView_priv.node) && 
+	              !IS_VFOLDER (htmlView_priv.node) && 
+	              (htmlView_priv.missingContent > 3);
+
+	if (ITEMVIEW_ALL_ITEMS == mode) {
+		htmlview_update_window (htmlview, summaryMode);
+
+		/* render all items not yet in the chunk cache */
+		htmlview_render_chunks (mode, summaryMode);
+
+		/* and try to avoid reloading everything */
+		if (htmlview_patch (htmlview, summaryMode))
+			return;
+	}
+
 	/* determine base URL */
 	switch (mode) {
 		case ITEMVIEW_SINGLE_ITEM:
@@ -358,51 +937,22 @@ htmlview_update (LifereaHtmlView *htmlview, itemViewMode mode)
 			}
 			break;
 		case ITEMVIEW_ALL_ITEMS:
-			/* Output optimization for feeds without item content. This
-			   is not done for folders, because we only support all items
-			   in summary mode or all in detailed mode. With folder item 
-			   sets displaying everything in summary because of only a
-			   single feed without item descriptions would make no sense. */
-
-			summaryMode = (NULL != htmlView_priv.node) &&
-			              !IS_FOLDER (htmlView_priv.node) && 
-	        		      !IS_VFOLDER (htmlView_priv.node) && 
-	        		      (htmlView_priv.missingContent > 3);
-
 			/* concatenate all items */
 			iter = htmlView_priv.orderedChunks;
 			while (iter) {
-				/* try to retrieve item HTML chunk from cache */
 				htmlChunkPtr chunk = (htmlChunkPtr)iter->data;
 				
-				/* if not found: render new item now and add to cache */
-				if (!chunk->html) {
-					item = item_load (chunk->id);
-					if (item) {
-						debug1 (DEBUG_HTML, "rendering item to HTML view: >>>%s<<<", item_get_title (item));
-						chunk->html = htmlview_render_item (item, mode, summaryMode);
-						item_unload (item);
-					}
+				if (chunk->html || htmlView_priv.windowed) {
+					htmlview_append_chunk (output, chunk);
+					chunk->shown = TRUE;
 				}
-				
-				if (chunk->html)
-					g_string_append (output, chunk->html);
 					
 				iter = g_slist_next (iter);
 			}
 			break;
 		case ITEMVIEW_NODE_INFO:
-			{
-				gchar *html;
-				
-				if (htmlView_priv.node) {
-					html = node_render (htmlView_priv.node);	
-					if (html) {
-						g_string_append (output, html);
-						g_free (html);
-					}
-				}
-			}
+			if (htmlView_priv.node)
+				node_render (htmlView_priv.node, output);
 			break;
 		default:
 			g_warning ("HTML view: invalid viewing mode!!!");
@@ -413,6 +963,14 @@ htmlview_update (LifereaHtmlView *htmlview, itemViewMode mode)
 
 	debug1 (DEBUG_HTML, "writing %d bytes to HTML view", strlen (output->str));
 	liferea_htmlview_write (htmlview, output->str, baseURL);
+
+	/* remember the document to patch it on later updates */
+	g_slist_free (htmlView_priv.removedIds);
+	htmlView_priv.removedIds = NULL;
+	htmlView_priv.patchView = (ITEMVIEW_ALL_ITEMS == mode)?htmlview:NULL;
+	htmlView_priv.patchDocument = liferea_htmlview_get_document_id (htmlview);
+	htmlView_priv.patchSummary = summaryMode;
+	htmlView_priv.patchWindowed = htmlView_priv.windowed;
 	
 	g_string_free (output, TRUE);
 	g_free (baseURL);
@@ -82,6 +82,15 @@ void	htmlview_select_item (itemPtr item);
  */
 void	htmlview_update_item (itemPtr item);
 
+/**
+ * Renders the given item for single item display in advance. This
+ * is to be used for items that are likely to be selected next.
+ * The result is kept in the render cache.
+ *
+ * @param item		the item to prefetch
+ */
+void	htmlview_prefetch_item (itemPtr item);
+
 /**
  * Like htmlview_update_item(), processes all items.
  */
@@ -96,6 +105,16 @@ void	htmlview_update_all_items (void);
  */
 void	htmlview_update (LifereaHtmlView *htmlview, itemViewMode mode);
 
+/**
+ * Renders the given items of a combined view that were left out
+ * by htmlview_update() and adds them to the HTML view. To be called
+ * when the HTML view scrolls near items not yet rendered.
+ *
+ * @param htmlview	HTML view to render to
+ * @param ids		comma separated list of item ids
+ */
+void	htmlview_load_items (LifereaHtmlView *htmlview, const gchar *ids);
+
 /** helper methods for HTML output */
 
 /**
@@ -0,0 +1,264 @@
+/**
+ * @file image_cache.c  local cache for item images
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "image_cache.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "common.h"
+#include "conf.h"
+#include "db.h"
+#include "debug.h"
+#include "metadata.h"
+#include "subscription.h"
+#include "update.h"
+#include "xml.h"
+
+#define IMAGE_CACHE_MAX_IMAGES		20		/**< maximum number of images cached per item */
+#define IMAGE_CACHE_MAX_SIZE		(512*1024)	/**< larger images are not cached */
+#define IMAGE_CACHE_CLEANUP_DELAY	60		/**< seconds from startup to the first cleanup */
+#define IMAGE_CACHE_CLEANUP_INTERVAL	(60*60)		/**< seconds between cleanups */
+
+/** file names of the images currently downloaded */
+static GHashTable *pendingDownloads = NULL;
+
+/** timeout source id of the next cleanup */
+static guint cleanupId = 0;
+
+/** the CACHE_IMAGES setting, kept as it is checked per web resource */
+static gboolean cacheEnabled = FALSE;
+
+static gchar *
+image_cache_get_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), "liferea", "images", NULL);
+}
+
+static gboolean
+image_cache_is_remote (const gchar *url)
+{
+	return g_str_has_prefix (url, "http://") || g_str_has_prefix (url, "https://");
+}
+
+static gchar *
+image_cache_get_filename (const gchar *hash)
+{
+	return common_create_cache_filename ("images", hash, NULL);
+}
+
+gchar *
+image_cache_get_file (const gchar *url)
+{
+	gchar	*hash, *filename;
+
+	if (!cacheEnabled || !image_cache_is_remote (url))
+		return NULL;
+
+	hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, url, -1);
+	filename = image_cache_get_filename (hash);
+	g_free (hash);
+
+	if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR)) {
+		g_free (filename);
+		return NULL;
+	}
+
+	return filename;
+}
+
+static void
+image_cache_download_cb (const struct updateResult * const result, gpointer user_data, updateFlags flags)
+{
+	gchar	*hash = (gchar *)user_data;
+	gchar	*filename;
+	GError	*error = NULL;
+
+	/* Do not cache error pages, but as for favicons we cannot
+	   rely on servers sending image MIME types */
+	if (result->data &&
+	    (result->size > 0) &&
+	    (result->size <= IMAGE_CACHE_MAX_SIZE) &&
+	    (200 == result->httpstatus) &&
+	    !(result->contentType && g_str_has_prefix (result->contentType, "text/"))) {
+		filename = image_cache_get_filename (hash);
+		debug2 (DEBUG_UPDATE, "saving image %s to file %s", result->source, filename);
+		if (!g_file_set_contents (filename, result->data, result->size, &error)) {
+			g_warning ("Could not save image to file %s (%s)!", filename, error->message);
+			g_error_free (error);
+		}
+		g_free (filename);
+	} else {
+		debug2 (DEBUG_UPDATE, "not caching image %s (%lu bytes)", result->source, (gulong)result->size);
+	}
+
+	if (pendingDownloads)
+		g_hash_table_remove (pendingDownloads, hash);
+	g_free (hash);
+}
+
+void
+image_cache_fetch_item (itemPtr item)
+{
+	GSList		*urls, *iter, *hashes = NULL;
+	const gchar	*value;
+	guint		count = 0;
+
+	if (!pendingDownloads || !cacheEnabled)
+		return;
+
+	urls = xhtml_get_image_urls (item_get_description (item), item_get_base_url (item));
+
+	/* photo thumbnails are stored as "<thumbnail URL>,<image URL>" */
+	value = metadata_list_get (item->metadata, "photo");
+	if (value)
+		urls = g_slist_append (urls, g_strndup (value, strcspn (value, ",")));
+
+	value = metadata_list_get (item->metadata, "gravatar");
+	if (value)
+		urls = g_slist_append (urls, g_strdup (value));
+
+	for (iter = urls; iter && (count < IMAGE_CACHE_MAX_IMAGES); iter = g_slist_next (iter)) {
+		const gchar	*url = (const gchar *)iter->data;
+		gchar		*hash, *filename;
+
+		if (!url || !image_cache_is_remote (url))
+			continue;
+
+		count++;
+		hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, url, -1);
+
+		/* also referenced when already cached for another item */
+		hashes = g_slist_prepend (hashes, g_strdup (hash));
+
+		filename = image_cache_get_filename (hash);
+		if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR) &&
+		    !g_hash_table_lookup_extended (pendingDownloads, hash, NULL, NULL)) {
+			updateRequestPtr request;
+
+			debug1 (DEBUG_UPDATE, "caching image %s", url);
+			g_hash_table_insert (pendingDownloads, g_strdup (hash), NULL);
+
+			/* no subscription options, as images are often
+			   on other hosts not to be sent any credentials */
+			request = update_request_new ();
+			update_request_set_source (request, url);
+			request->options = g_new0 (struct updateOptions, 1);
+			update_execute_request (NULL, request, image_cache_download_cb, g_strdup (hash), FEED_REQ_PRIORITY_LOW);
+		}
+
+		g_free (filename);
+		g_free (hash);
+	}
+
+	for (iter = urls; iter; iter = g_slist_next (iter))
+		g_free (iter->data);
+	g_slist_free (urls);
+
+	db_item_images_add (item->id, hashes);
+	for (iter = hashes; iter; iter = g_slist_next (iter))
+		g_free (iter->data);
+	g_slist_free (hashes);
+}
+
+/* Removes all cached images no longer used by any item, which
+   happens when items are dropped because of the cache limits */
+static void
+image_cache_cleanup (void)
+{
+	GHashTable	*used;
+	GDir		*dir;
+	const gchar	*name;
+	gchar		*path, *filename;
+	guint		removed = 0;
+
+	path = image_cache_get_path ();
+	dir = g_dir_open (path, 0, NULL);
+	if (!dir) {
+		g_free (path);
+		return;
+	}
+
+	debug_start_measurement (DEBUG_CACHE);
+
+	used = db_item_images_load ();
+	while (NULL != (name = g_dir_read_name (dir))) {
+		if (g_hash_table_lookup_extended (used, name, NULL, NULL) ||
+		    g_hash_table_lookup_extended (pendingDownloads, name, NULL, NULL))
+			continue;
+
+		filename = g_build_filename (path, name, NULL);
+		if (0 == g_unlink (filename))
+			removed++;
+		g_free (filename);
+	}
+	g_dir_close (dir);
+	g_hash_table_destroy (used);
+	g_free (path);
+
+	debug1 (DEBUG_CACHE, "removed %u unused cached images", removed);
+	debug_end_measurement (DEBUG_CACHE, "image cache cleanup");
+}
+
+static gboolean
+image_cache_cleanup_cb (gpointer user_data)
+{
+	image_cache_cleanup ();
+
+	cleanupId = g_timeout_add_seconds (IMAGE_CACHE_CLEANUP_INTERVAL, image_cache_cleanup_cb, NULL);
+
+	return FALSE;
+}
+
+static void
+image_cache_enabled_cb (GSettings *gsettings,
+                        gchar *key,
+                        gpointer user_data)
+{
+	g_return_if_fail (key != NULL);
+
+	cacheEnabled = g_settings_get_boolean (gsettings, key);
+}
+
+void
+image_cache_init (void)
+{
+	conf_get_bool_value (CACHE_IMAGES, &cacheEnabled);
+	conf_signal_connect ("changed::" CACHE_IMAGES, G_CALLBACK (image_cache_enabled_cb), NULL);
+
+	pendingDownloads = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	/* not during startup, which is busy enough */
+	cleanupId = g_timeout_add_seconds (IMAGE_CACHE_CLEANUP_DELAY, image_cache_cleanup_cb, NULL);
+}
+
+void
+image_cache_deinit (void)
+{
+	if (cleanupId) {
+		g_source_remove (cleanupId);
+		cleanupId = 0;
+	}
+
+	if (pendingDownloads) {
+		g_hash_table_destroy (pendingDownloads);
+		pendingDownloads = NULL;
+	}
+}
@@ -0,0 +1,66 @@
+/**
+ * @file image_cache.h  local cache for item images
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _IMAGE_CACHE_H
+#define _IMAGE_CACHE_H
+
+#include <glib.h>
+
+#include "item.h"
+
+/* The image cache keeps local copies of the images referenced by
+   item descriptions and of item thumbnails, so items can be read
+   quickly on slow connections and also offline. When enabled the
+   images of newly merged items are downloaded with low priority.
+   The files are named by the SHA1 of the image URL. Each cached
+   image is referenced by the items using it (see db_item_images_add()),
+   so it is removed once all those items have been dropped from the
+   item cache. */
+
+/**
+ * Sets up the image cache and schedules the periodic removal
+ * of images no longer used by any item. To be called after db_init().
+ */
+void image_cache_init (void);
+
+/**
+ * Stops the image cache processing.
+ */
+void image_cache_deinit (void);
+
+/**
+ * Downloads the images of a newly merged item that are not yet
+ * cached. Does nothing if image caching is disabled.
+ *
+ * @param item		the item (must have been written to the DB)
+ */
+void image_cache_fetch_item (itemPtr item);
+
+/**
+ * Returns the cache file for the given image URL.
+ *
+ * @param url		the image URL
+ *
+ * @returns the file name (to be free'd using g_free) or NULL
+ *          if image caching is disabled or the image is not cached
+ */
+gchar * image_cache_get_file (const gchar *url);
+
+#endif
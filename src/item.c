@@ -32,23 +32,153 @@
 #include "metadata.h"
 #include "xml.h"
 
+/* Item arenas: items are allocated in blocks of ITEM_ARENA_BLOCK_SIZE
+   structures, their strings are kept in one string chunk. Items of an
+   arena are never free'd individually. */
+
+#define ITEM_ARENA_BLOCK_SIZE	64
+
+struct itemArena {
+	GStringChunk	*strings;	/**< all strings of the arena items */
+	GSList		*blocks;	/**< item blocks, the first one is the current block */
+	guint		blockUsed;	/**< number of used items in the current block */
+	guint		itemCount;	/**< number of items allocated from this arena */
+	gsize		stringBytes;	/**< number of string bytes allocated from this arena */
+};
+
+/* allocation statistics for DEBUG_PERF */
+static guint	heapItemCount = 0;
+static guint	arenaItemCount = 0;
+static guint	arenaCount = 0;
+
+itemArenaPtr
+item_arena_new (void)
+{
+	itemArenaPtr	arena;
+
+	arena = g_new0 (struct itemArena, 1);
+	arena->strings = g_string_chunk_new (16384);
+	arenaCount++;
+
+	return arena;
+}
+
+void
+item_arena_free (itemArenaPtr arena)
+{
+	GSList	*iter;
+	guint	i, used;
+
+	if (!arena)
+		return;
+
+	debug3 (DEBUG_PERF, "item arena: %u items, %u blocks, %lu string bytes",
+	        arena->itemCount, g_slist_length (arena->blocks), (gulong)arena->stringBytes);
+	debug3 (DEBUG_PERF, "item allocation totals: %u heap items, %u arena items in %u arenas",
+	        heapItemCount, arenaItemCount, arenaCount);
+
+	/* only metadata lists are allocated separately */
+	used = arena->blockUsed;
+	iter = arena->blocks;
+	while (iter) {
+		itemPtr block = (itemPtr)iter->data;
+
+		for (i = 0; i < used; i++)
+			metadata_list_free (block[i].metadata);
+
+		g_free (block);
+		used = ITEM_ARENA_BLOCK_SIZE;
+		iter = g_slist_next (iter);
+	}
+	g_slist_free (arena->blocks);
+	g_string_chunk_free (arena->strings);
+
+	g_free (arena);
+}
+
 itemPtr
-item_new (void)
+item_arena_item_new (itemArenaPtr arena)
 {
 	itemPtr		item;
-	
-	item = g_new0 (struct item, 1);
+
+	if (!arena) {
+		item = g_new0 (struct item, 1);
+		heapItemCount++;
+	} else {
+		if (!arena->blocks || arena->blockUsed == ITEM_ARENA_BLOCK_SIZE) {
+			arena->blocks = g_slist_prepend (arena->blocks, g_new0 (struct item, ITEM_ARENA_BLOCK_SIZE));
+			arena->blockUsed = 0;
+		}
+		item = (itemPtr)arena->blocks->data + arena->blockUsed++;
+		item->arena = arena;
+		arena->itemCount++;
+		arenaItemCount++;
+	}
+
 	item->popupStatus = TRUE;
-	
+
 	return item;
 }
 
+itemPtr
+item_new (void)
+{
+	return item_arena_item_new (NULL);
+}
+
 itemPtr
 item_load (gulong id)
 {
 	return db_item_load (id);
 }
 
+itemPtr
+item_arena_load (itemArenaPtr arena, gulong id)
+{
+	return db_item_load_with_arena (id, arena);
+}
+
+gchar *
+item_strdup (itemPtr item, const gchar *str)
+{
+	if (!item->arena || !str)
+		return g_strdup (str);
+
+	item->arena->stringBytes += strlen (str) + 1;
+	return g_string_chunk_insert (item->arena->strings, str);
+}
+
+/* Takes ownership of a newly allocated string for an item property */
+static gchar *
+item_take_string (itemPtr item, gchar *str)
+{
+	gchar	*result;
+
+	if (!item->arena || !str)
+		return str;
+
+	result = item_strdup (item, str);
+	g_free (str);
+	return result;
+}
+
+static void
+item_free_string (itemPtr item, gchar *str)
+{
+	if (!item->arena)
+		g_free (str);
+}
+
+/* Drops the cached search texts after a title or description change */
+static void
+item_reset_search_text (itemPtr item)
+{
+	item_free_string (item, item->searchText);
+	item_free_string (item, item->foldedSearchText);
+	item->searchText = NULL;
+	item->foldedSearchText = NULL;
+}
+
 itemPtr
 item_copy (itemPtr item)
 {
@@ -57,6 +187,7 @@ item_copy (itemPtr item)
 	item_set_title (copy, item->title);
 	item_set_source (copy, item->source);
 	item_set_description (copy, item->description);
+	copy->sanitized = item->sanitized;
 	item_set_id (copy, item->sourceId);
 	
 	copy->updateStatus = item->updateStatus;
@@ -83,12 +214,13 @@ item_copy (itemPtr item)
 void
 item_set_title (itemPtr item, const gchar * title)
 {
-	g_free (item->title);
+	item_free_string (item, item->title);
+	item_reset_search_text (item);
 
 	if (!title)
 		title = "";
 
-	item->title = g_strstrip (g_strdelimit (g_strdup (title), "\r\n", ' '));
+	item->title = item_take_string (item, g_strstrip (g_strdelimit (g_strdup (title), "\r\n", ' ')));
 }
 
 void
@@ -101,16 +233,40 @@ item_set_description (itemPtr item, const gchar *description)
 		if (!(strlen (description) > strlen (item->description)))
 			return;
 
-	g_free (item->description);
-	item->description = g_strdup (description);
+	item_free_string (item, item->description);
+	item_reset_search_text (item);
+	item->description = item_strdup (item, description);
+	item->sanitized = 0;
+}
+
+void
+item_replace_description (itemPtr item, gchar *description)
+{
+	item_free_string (item, item->description);
+	item_reset_search_text (item);
+	item->description = item_take_string (item, description);
+	item->sanitized = 0;
+}
+
+gboolean
+item_sanitize_description (itemPtr item)
+{
+	if (XHTML_STRIP_VERSION == item->sanitized)
+		return FALSE;
+
+	if (item->description)
+		item_replace_description (item, xhtml_strip_dhtml_and_unsupported_tags (item->description));
+	item->sanitized = XHTML_STRIP_VERSION;
+
+	return TRUE;
 }
 
 void
 item_set_source (itemPtr item, const gchar * source)
 {
-	g_free (item->source);
+	item_free_string (item, item->source);
 	if (source) 
-		item->source = g_strstrip (g_strdup (source));
+		item->source = item_take_string (item, g_strstrip (g_strdup (source)));
 	else
 		item->source = NULL;
 }
@@ -118,8 +274,8 @@ item_set_source (itemPtr item, const gchar * source)
 void
 item_set_id (itemPtr item, const gchar * id)
 {
-	g_free (item->sourceId);
-	item->sourceId = g_strdup (id);
+	item_free_string (item, item->sourceId);
+	item->sourceId = item_strdup (item, id);
 }
 
 const gchar *	item_get_id(itemPtr item) { return item->sourceId; }
@@ -127,6 +283,29 @@ const gchar *	item_get_title(itemPtr item) {return item->title; }
 const gchar *	item_get_description(itemPtr item) { return item->description; }
 const gchar *	item_get_source(itemPtr item) { return item->source; }
 
+const gchar *
+item_get_search_text (itemPtr item)
+{
+	gchar	*description;
+
+	if (!item->searchText) {
+		description = unhtmlize (g_strdup (item->description));
+		item->searchText = item_take_string (item, g_strjoin ("\n", item->title?item->title:"", description?description:"", NULL));
+		g_free (description);
+	}
+
+	return item->searchText;
+}
+
+const gchar *
+item_get_folded_search_text (itemPtr item)
+{
+	if (!item->foldedSearchText)
+		item->foldedSearchText = item_take_string (item, g_utf8_casefold (item_get_search_text (item), -1));
+
+	return item->foldedSearchText;
+}
+
 gchar *
 item_make_link (itemPtr item)
 {
@@ -170,16 +349,21 @@ item_make_link (itemPtr item)
 void
 item_unload (itemPtr item) 
 {
+	g_assert (NULL == item->tmpdata);	/* should be free after rendering */
+	metadata_list_free (item->metadata);
+	item->metadata = NULL;
+
+	/* arena items are released with their arena */
+	if (item->arena)
+		return;
+
 	g_free (item->title);
 	g_free (item->source);
 	g_free (item->sourceId);
 	g_free (item->description);
 	g_free (item->commentFeedId);
-	g_free (item->nodeId);
-	g_free (item->parentNodeId);
-	
-	g_assert (NULL == item->tmpdata);	/* should be free after rendering */
-	metadata_list_free (item->metadata);
+	g_free (item->searchText);
+	g_free (item->foldedSearchText);
 
 	g_free (item);
 }
@@ -192,93 +376,121 @@ item_get_base_url (itemPtr item)
 	return node_get_base_url (node_from_id (item->nodeId));
 }
 
-void
-item_to_xml (itemPtr item, gpointer xmlNode)
+/* Serializes the item into the given XML node or, if a key is given,
+   appends all serialized values to the render key instead. Returns
+   FALSE if the item output depends on data not covered by a key. */
+static gboolean
+item_serialize (itemPtr item, xmlNodePtr parentNode, GString *key)
 {
-	xmlNodePtr	parentNode = (xmlNodePtr)xmlNode;
 	xmlNodePtr	duplicatesNode;		
 	xmlNodePtr	itemNode;
 	gchar		*tmp;
-	gchar		*tmp2;
 	
-	itemNode = xmlNewChild (parentNode, NULL, "item", NULL);
-	g_return_if_fail (itemNode);
+	itemNode = xml_add_child (parentNode, key, "item");
+	g_return_val_if_fail (itemNode || key, FALSE);
 
-	xmlNewTextChild (itemNode, NULL, "title", item_get_title (item)?item_get_title (item):"");
+	xml_add_text_child (itemNode, key, "title", item_get_title (item)?item_get_title (item):"");
 
+	/* descriptions are stored stripped, only items not
+	   merged yet might need stripping here */
 	if (item_get_description (item)) {
-		tmp = xhtml_strip_dhtml (item_get_description (item));
-		tmp2 = xhtml_strip_unsupported_tags (tmp);
-		xmlNewTextChild (itemNode, NULL, "description", tmp2);
-		g_free (tmp);
-		g_free (tmp2);
+		if (key || (XHTML_STRIP_VERSION == item->sanitized)) {
+			/* stripping does not change stripped descriptions, 
+			   so the stored one also identifies a stripped copy */
+			xml_add_text_child (itemNode, key, "description", item_get_description (item));
+		} else {
+			tmp = xhtml_strip_dhtml_and_unsupported_tags (item_get_description (item));
+			xml_add_text_child (itemNode, key, "description", tmp);
+			g_free (tmp);
+		}
 	}
 	
 	if (item_get_source (item))
-		xmlNewTextChild (itemNode, NULL, "source", item_get_source (item));
+		xml_add_text_child (itemNode, key, "source", item_get_source (item));
 
 	tmp = g_strdup_printf ("%ld", item->id);
-	xmlNewTextChild (itemNode, NULL, "nr", tmp);
+	xml_add_text_child (itemNode, key, "nr", tmp);
 	g_free (tmp);
 
 	tmp = g_strdup_printf ("%d", item->readStatus?1:0);
-	xmlNewTextChild (itemNode, NULL, "readStatus", tmp);
+	xml_add_text_child (itemNode, key, "readStatus", tmp);
 	g_free (tmp);
 
 	tmp = g_strdup_printf ("%d", item->updateStatus?1:0);
-	xmlNewTextChild (itemNode, NULL, "updateStatus", tmp);
+	xml_add_text_child (itemNode, key, "updateStatus", tmp);
 	g_free (tmp);
 
 	tmp = g_strdup_printf ("%d", item->flagStatus?1:0);
-	xmlNewTextChild (itemNode, NULL, "mark", tmp);
+	xml_add_text_child (itemNode, key, "mark", tmp);
 	g_free (tmp);
 
 	tmp = g_strdup_printf ("%ld", item->time);
-	xmlNewTextChild (itemNode, NULL, "time", tmp);
+	xml_add_text_child (itemNode, key, "time", tmp);
 	g_free (tmp);
 
 	tmp = date_format (item->time, NULL);
-	xmlNewTextChild (itemNode, NULL, "timestr", tmp);
+	xml_add_text_child (itemNode, key, "timestr", tmp);
 	g_free (tmp);
 
 	if (item->validGuid) {
 		GSList	*iter, *duplicates;
 		
-		duplicatesNode = xmlNewChild(itemNode, NULL, "duplicates", NULL);
-		duplicates = iter = db_item_get_duplicates(item->sourceId);
-		while (iter) {
-			gulong id = GPOINTER_TO_UINT (iter->data);
-			itemPtr duplicate = item_load (id);
-			if (duplicate) {
-				nodePtr duplicateNode = node_from_id (duplicate->nodeId);
-				if (duplicateNode && (item->id != duplicate->id))
-					xmlNewTextChild (duplicatesNode, NULL, "duplicateNode", 
-					                 node_get_title (duplicateNode));
-				item_unload (duplicate);
+		duplicatesNode = xml_add_child (itemNode, key, "duplicates");
+
+		/* the duplicate count saves the query for most items */
+		if (item->duplicates > 0) {
+			duplicates = iter = db_item_get_duplicate_nodes (item->sourceId, item->id);
+			while (iter) {
+				nodePtr duplicateNode = node_from_id ((gchar *)iter->data);
+				if (duplicateNode)
+					xml_add_text_child (duplicatesNode, key, "duplicateNode", 
+					                    node_get_title (duplicateNode));
+				g_free (iter->data);
+				iter = g_slist_next (iter);
 			}
-			iter = g_slist_next (iter);
+			g_slist_free (duplicates);
 		}
-		g_slist_free (duplicates);
 	}
 		
-	xmlNewTextChild (itemNode, NULL, "sourceId", item->nodeId);
+	xml_add_text_child (itemNode, key, "sourceId", item->nodeId);
 		
 	tmp = g_strdup_printf ("%ld", item->id);
-	xmlNewTextChild (itemNode, NULL, "sourceNr", tmp);
+	xml_add_text_child (itemNode, key, "sourceNr", tmp);
 	g_free (tmp);
 
-	metadata_add_xml_nodes (item->metadata, itemNode);
+	if (key)
+		metadata_list_to_render_key (item->metadata, key);
+	else
+		metadata_add_xml_nodes (item->metadata, itemNode);
 
 	nodePtr feedNode = node_from_id (item->parentNodeId);
 	if (feedNode) {
 		feedPtr feed = (feedPtr)feedNode->data;
 		if (feed) {
 			if (!feed->ignoreComments) {
-				if (item->commentFeedId)
+				if (item->commentFeedId) {
+					/* comments are loaded from their own feed */
+					if (key)
+						return FALSE;
 					comments_to_xml (itemNode, item->commentFeedId);
+				}
 			} else {
-				xmlNewTextChild (itemNode, NULL, "commentsSuppressed", "true");
+				xml_add_text_child (itemNode, key, "commentsSuppressed", "true");
 			}
 		}
 	}
+
+	return TRUE;
+}
+
+void
+item_to_xml (itemPtr item, gpointer xmlNode)
+{
+	item_serialize (item, (xmlNodePtr)xmlNode, NULL);
+}
+
+gboolean
+item_to_render_key (itemPtr item, GString *key)
+{
+	return item_serialize (item, NULL, key);
 }
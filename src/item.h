@@ -41,6 +41,8 @@
  *  folder,vfolder or plugin). Each item has a source node.
  *  The item set node and the item source node is different
  *  for folders and vfolders. */
+typedef struct itemArena *itemArenaPtr;
+
 typedef struct item {
 	gulong		id;			/**< internally unique item id */
 
@@ -54,9 +56,11 @@ typedef struct item {
 	gchar		*source;		/**< URL to the post online */
 	gchar		*sourceId;		/**< "Unique" syndication item identifier, for example <guid> in RSS */
 	gboolean	validGuid;		/**< TRUE if id of this item is a GUID and can be used for duplicate detection */
+	guint		duplicates;		/**< Number of other items with the same GUID as counted on merging (might be too high after item removals) */
 	gchar		*description;		/**< XHTML string containing the item's description */
+	guint		sanitized;		/**< XHTML_STRIP_VERSION the description was stripped with (0 if not stripped) */
 	
-	GSList		*metadata;		/**< Metadata of this item */
+	struct metadataList *metadata;		/**< Metadata of this item */
 	GHashTable	*tmpdata;		/**< Temporary data hash used during stateful parsing */
 	time_t		time;			/**< Last modified date of the headline */
 
@@ -67,9 +71,14 @@ typedef struct item {
 	gboolean	isComment;		/**< TRUE if item is from a comment feed */
 
 	/* item source properties */
-	gchar		*nodeId;		/**< Node id the containing node. Might be a comment feed id. */
-	gchar		*parentNodeId;		/**< Real parent node id. Always a feed list node id. */
+	const gchar	*nodeId;		/**< Node id the containing node. Might be a comment feed id. (interned string) */
+	const gchar	*parentNodeId;		/**< Real parent node id. Always a feed list node id. (interned string) */
 	gulong 		sourceNr;		/**< Either equal to nr or the number of the item this one is a copy of */
+
+	itemArenaPtr	arena;			/**< Arena the item and its strings were allocated from (or NULL) */
+
+	gchar		*searchText;		/**< Cached plain text of title and description (or NULL if not yet needed) */
+	gchar		*foldedSearchText;	/**< Cached case folded search text (or NULL if not yet needed) */
 } *itemPtr;
 
 /**
@@ -97,6 +106,55 @@ itemPtr		item_load(gulong id);
  */
 itemPtr		item_copy(itemPtr item);
 
+/**
+ * Item arenas are to be used by bulk operations (merging, search
+ * folder rebuilds...) that load many short living items. Arena
+ * items and their strings are allocated in a few large blocks
+ * that are released all at once by item_arena_free(). Arena items
+ * may be passed to item_unload() as usual, but must not be used
+ * after the arena was free'd.
+ *
+ * @returns a new item arena
+ */
+itemArenaPtr	item_arena_new(void);
+
+/**
+ * Releases an item arena and all items allocated from it.
+ *
+ * @param arena	the arena to free
+ */
+void		item_arena_free(itemArenaPtr arena);
+
+/**
+ * Allocates a new item structure from the given arena.
+ *
+ * @param arena	the arena (or NULL to allocate from the heap)
+ *
+ * @returns the new structure
+ */
+itemPtr		item_arena_item_new(itemArenaPtr arena);
+
+/**
+ * Like item_load(), but allocates the item from the given arena.
+ *
+ * @param arena	the arena
+ * @param id	item id to load
+ *
+ * @returns item structure (or NULL)
+ */
+itemPtr		item_arena_load(itemArenaPtr arena, gulong id);
+
+/**
+ * Duplicates a string for use as a property of the given item.
+ * For arena items the copy is allocated from the arena.
+ *
+ * @param item	the item the string is for
+ * @param str	the string to duplicate (or NULL)
+ *
+ * @returns copy of str (or NULL)
+ */
+gchar *		item_strdup(itemPtr item, const gchar *str);
+
 /**
  * Returns the base URL for the given item.
  *
@@ -124,6 +182,27 @@ const gchar *	item_get_description(itemPtr item);
 /** Returns the source of item. */
 const gchar *	item_get_source(itemPtr item);
 
+/**
+ * Returns the plain text of the item title and description
+ * (with all markup stripped) to be searched by search rules.
+ * The text is created once and cached with the item.
+ *
+ * @param item	the item
+ *
+ * @returns plain text (owned by the item)
+ */
+const gchar *	item_get_search_text (itemPtr item);
+
+/**
+ * Returns the case folded plain text of the item title and
+ * description. The text is created once and cached with the item.
+ *
+ * @param item	the item
+ *
+ * @returns case folded plain text (owned by the item)
+ */
+const gchar *	item_get_folded_search_text (itemPtr item);
+
 /**
  * Returns the resolved link for the item.
  *
@@ -146,6 +225,25 @@ void		item_set_title(itemPtr item, const gchar * title);
  */
 void item_set_description (itemPtr item, const gchar *description);
 
+/**
+ * Replaces the item description without any merging.
+ *
+ * @param item		the item
+ * @param description	the new content (will be owned by the item)
+ */
+void item_replace_description (itemPtr item, gchar *description);
+
+/**
+ * Strips DHTML and unsupported tags from the item description
+ * unless this was already done with the current stripping rules.
+ * Descriptions are stripped once when merging and stored stripped.
+ *
+ * @param item		the item
+ *
+ * @returns TRUE if the description was stripped
+ */
+gboolean item_sanitize_description (itemPtr item);
+
 /** Sets the item source */
 void		item_set_source(itemPtr item, const gchar * source);
 /** Sets the item id */
@@ -159,4 +257,16 @@ void		item_set_id(itemPtr item, const gchar * id);
  */
 void item_to_xml (itemPtr item, gpointer parentNode);
 
+/**
+ * Appends everything item_to_xml() would serialize to the given
+ * render cache key.
+ *
+ * @param item		the item
+ * @param key		the key to append to
+ *
+ * @returns FALSE if the rendered item cannot be cached
+ *          (because it includes comments)
+ */
+gboolean item_to_render_key (itemPtr item, GString *key);
+
 #endif
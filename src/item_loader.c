@@ -106,13 +106,17 @@ item_loader_fetch (gpointer user_data)
 {
 	ItemLoader	*il = ITEM_LOADER (user_data);
 	GSList		*resultItems = NULL;
+	itemArenaPtr	arena;
 	gboolean	result;
 
-	result = (*il->priv->fetchCallback)(il->priv->fetchCallbackData, &resultItems);
+	/* Batch items are only valid during signal emission */
+	arena = item_arena_new ();
+	result = (*il->priv->fetchCallback)(il->priv->fetchCallbackData, arena, &resultItems);
 	if (result)
 		g_signal_emit_by_name (il, "item-batch-fetched", resultItems);
 	else
 		g_signal_emit_by_name (il, "finished");
+	item_arena_free (arena);
 
 	return result;
 }
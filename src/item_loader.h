@@ -23,6 +23,7 @@
 
 #include <glib-object.h>
 
+#include "item.h"
 #include "node.h"
 
 /* ItemLoader concept: an ItemLoader instance runs a fetch callback
@@ -58,12 +59,16 @@ GType item_loader_get_type (void);
  * is called multiple times to fetch item batches. The
  * batch size is determined by the specific implementation.
  * 
+ * The result items may be allocated from the passed arena
+ * which is free'd after the batch was processed.
+ *
  * @param user_data	ItemLoader type specific data
+ * @param arena		item arena for the batch
  * @param items		Result items (to be free'd by caller)
  * 
  * @returns FALSE if loading has finished
  */
-typedef gboolean (*fetchCallbackPtr)(gpointer user_data, GSList **items);
+typedef gboolean (*fetchCallbackPtr)(gpointer user_data, itemArenaPtr arena, GSList **items);
 
 /**
  * Set up a new item loader with a specific fetch function.
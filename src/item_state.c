@@ -29,12 +29,6 @@
 #include "vfolder.h"
 #include "fl_sources/node_source.h"
 
-static void
-item_state_set_recount_flag (nodePtr node)
-{
-	node->needsRecount = TRUE;
-}
-
 void
 item_set_flag_state (itemPtr item, gboolean newState) 
 {	
@@ -50,16 +44,14 @@ item_flag_state_changed (itemPtr item, gboolean newState)
 	/* 1. set value in memory */	
 	item->flagStatus = newState;
 
-	/* 2. save state to DB */
+	/* 2. save state to DB (also passes counter
+	      changes to the affected vfolders) */
 	db_item_state_update (item);
 
-	/* 3. update vfolder counters */
-	vfolder_foreach (node_update_counters);
-
-	/* 4. update item list GUI state */
+	/* 3. update item list GUI state */
 	itemlist_update_item (item);
 
-	/* 5. update notification statistics */
+	/* 4. update notification statistics */
 	feedlist_reset_new_item_count ();
 
 	/* no duplicate state propagation to avoid copies 
@@ -91,23 +83,21 @@ item_read_state_changed (itemPtr item, gboolean newState)
 	item->readStatus = newState;
 	item->updateStatus = FALSE;
 
-	/* 2. apply to DB */
+	/* 2. apply to DB (also passes counter
+	      changes to the affected vfolders) */
 	db_item_state_update (item);
 
-	/* 3. propagate to vfolders */
-	vfolder_foreach (node_update_counters);
-	
-	/* 4. update item list GUI state */
+	/* 3. update item list GUI state */
 	itemlist_update_item (item);
 
-	/* 5. updated feed list unread counters */
+	/* 4. updated feed list unread counters */
 	node = node_from_id (item->nodeId);
-	node_update_counters (node);
+	node_schedule_update_counters (node);
 
-	/* 6. update notification statistics */
+	/* 5. update notification statistics */
 	feedlist_reset_new_item_count ();
 
-	/* 7. duplicate state propagation */
+	/* 6. duplicate state propagation */
 	if (item->validGuid) {
 		GSList *duplicates, *iter;
 
@@ -132,54 +122,102 @@ item_read_state_changed (itemPtr item, gboolean newState)
 	debug_end_measurement (DEBUG_GUI, "set read status");
 }
 
+/* collects the ids of all nodes of a subtree whose items to mark */
+struct markReadCtxt {
+	GSList	*nodeIds;		/**< ids of nodes with items */
+	GSList	*searchFolderIds;	/**< ids of search folders */
+};
+
+static void
+itemset_mark_read_collect (nodePtr node, gpointer user_data)
+{
+	struct markReadCtxt *ctxt = (struct markReadCtxt *)user_data;
+
+	if (IS_VFOLDER (node))
+		ctxt->searchFolderIds = g_slist_prepend (ctxt->searchFolderIds, node->id);
+	else
+		ctxt->nodeIds = g_slist_prepend (ctxt->nodeIds, node->id);
+
+	if (node->children)
+		node_foreach_child_data (node, itemset_mark_read_collect, ctxt);
+}
+
 /**
  * In difference to all the other item state handling methods
  * item_state_set_all_read does not immediately apply the 
  * changes to the GUI because it is usually called recursively
- * and would be to slow. Instead the node structure flag for
- * recounting is set. By calling feedlist_update() afterwards
- * those recounts are executed and applied to the GUI.
+ * and would be to slow. Instead the affected nodes are scheduled
+ * for recounting, which is done in one pass from an idle callback.
+ *
+ * To be fast for large item sets the items are not loaded, 
+ * but marked in the DB for the whole node subtree at once.
+ * Only items that need remote state synchronization are loaded.
  */
 void
 itemset_mark_read (nodePtr node)
 {
-	itemSetPtr	itemSet;
-
-	itemSet = node_get_itemset (node);
-	GList *iter = itemSet->ids;
-	while (iter) {
-		gulong id = GPOINTER_TO_UINT (iter->data);
-		itemPtr item = item_load (id);
-		if (item) {
-			if (!item->readStatus) {
-				nodePtr node = node_from_id (item->nodeId);
-				if (node) {
-					item_state_set_recount_flag (node);
-					node_source_item_mark_read (node, item, TRUE);
-				}
-
-				debug_start_measurement (DEBUG_GUI);
-
-				GSList *duplicates = db_item_get_duplicate_nodes (item->sourceId);
-				GSList *duplicate = duplicates;
-				while (duplicate) {
-					gchar *nodeId = (gchar *)duplicate->data;
-					nodePtr affectedNode = node_from_id (nodeId);
-					if (affectedNode)
-						item_state_set_recount_flag (affectedNode);
-					g_free (nodeId);
-					duplicate = g_slist_next (duplicate);
-				}
-				g_slist_free(duplicates);
-
-				debug_end_measurement (DEBUG_GUI, "mark read of duplicates");
-			}
-			item_unload (item);
+	struct markReadCtxt	ctxt = { NULL, NULL };
+	GHashTable		*items, *syncItems;
+	GHashTableIter		iter;
+	gpointer		id, nodeId;
+	GSList			*syncIds;
+	nodePtr			root;
+
+	debug_start_measurement (DEBUG_GUI);
+
+	/* 1. Mark all items and their duplicates in one DB update */
+	itemset_mark_read_collect (node, &ctxt);
+	items = db_itemset_mark_read (ctxt.nodeIds, ctxt.searchFolderIds);
+	g_slist_free (ctxt.nodeIds);
+	g_slist_free (ctxt.searchFolderIds);
+
+	/* 2. Flag affected nodes for recounting and collect the 
+	      items to be sync'ed with remote sources */
+	syncItems = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_hash_table_iter_init (&iter, items);
+	while (g_hash_table_iter_next (&iter, &id, &nodeId)) {
+		nodePtr affectedNode = node_from_id ((const gchar *)nodeId);
+		if (!affectedNode)
+			continue;
+
+		node_schedule_update_counters (affectedNode);
+
+		if (NODE_SOURCE_TYPE (affectedNode)->capabilities & NODE_SOURCE_CAPABILITY_ITEM_STATE_SYNC) {
+			root = node_source_root_from_node (affectedNode);
+			syncIds = g_hash_table_lookup (syncItems, root);
+			g_hash_table_insert (syncItems, root, g_slist_prepend (syncIds, id));
+		}
+	}
+
+	/* 3. One batched remote state sync per node source */
+	g_hash_table_iter_init (&iter, syncItems);
+	while (g_hash_table_iter_next (&iter, (gpointer *)&root, (gpointer *)&syncIds)) {
+		itemArenaPtr	arena = item_arena_new ();
+		GSList		*list = NULL, *iter2;
+
+		for (iter2 = syncIds; iter2; iter2 = g_slist_next (iter2)) {
+			itemPtr item = item_arena_load (arena, GPOINTER_TO_UINT (iter2->data));
+			if (item)
+				list = g_slist_prepend (list, item);
 		}
-		iter = g_list_next (iter);
+
+		node_source_items_mark_read (root, list);
+
+		g_slist_free (list);
+		g_slist_free (syncIds);
+		item_arena_free (arena);
 	}
+	g_hash_table_destroy (syncItems);
+
+	/* 4. Update search folder memberships */
+	if (g_hash_table_size (items) > 0) {
+		vfolder_update_read_items (items);
+		vfolder_foreach (vfolder_recount);
+	}
+
+	g_hash_table_destroy (items);
 
-	// FIXME: why not call itemset_free (itemSet); here? Crashes!
+	debug_end_measurement (DEBUG_GUI, "mark all read");
 }
 
 void
@@ -59,9 +59,10 @@ void item_set_read_state (itemPtr item, gboolean newState);
 void item_read_state_changed (itemPtr item, gboolean newState);
 
 /**
- * Requests to mark read all items in the given nodes item list.
+ * Requests to mark read all items in the given nodes item list
+ * and in the item lists of all its child nodes.
  *
- * @param nodeId	the node whose item list is to be modified
+ * @param node		the node whose item list is to be modified
  */
 void itemset_mark_read (nodePtr node);
 
@@ -470,9 +470,8 @@ itemlist_remove_item (itemPtr item)
 
 	db_item_remove (item->id);
 
-	/* update feed list counters*/
-	vfolder_foreach (node_update_counters);
-	node_update_counters (node_from_id (item->nodeId));
+	/* update feed list counters (vfolders get their changes from the DB layer) */
+	node_schedule_update_counters (node_from_id (item->nodeId));
 	
 	item_unload (item);
 }
@@ -514,8 +513,7 @@ itemlist_remove_items (itemSetPtr itemSet, GList *items)
 	}
 
 	itemview_update ();
-	vfolder_foreach (node_update_counters);
-	node_update_counters (node_from_id (itemSet->nodeId));
+	node_schedule_update_counters (node_from_id (itemSet->nodeId));
 }
 
 void
@@ -531,8 +529,8 @@ itemlist_remove_all_items (nodePtr node)
 		itemlist_duplicate_list_free ();
 	}
 
-	vfolder_foreach (node_update_counters);
-	node_update_counters (node);
+	vfolder_foreach (vfolder_recount);
+	node_schedule_update_counters (node);
 }
 
 void
@@ -586,6 +584,7 @@ itemlist_selection_changed (itemPtr item)
 
 				itemview_select_item (item);
 				itemview_update ();
+				itemview_prefetch_items ();
 			}
 			ui_node_update (item->nodeId);
 		}
@@ -26,27 +26,30 @@
 #include "debug.h"
 #include "enclosure.h"
 #include "feed.h"
+#include "image_cache.h"
 #include "itemlist.h"
 #include "itemset.h"
 #include "metadata.h"
 #include "node.h"
 #include "rule.h"
-#include "vfolder.h"
 #include "fl_sources/node_source.h"
 
 void
 itemset_foreach (itemSetPtr itemSet, itemActionFunc callback)
 {
-	GList	*iter = itemSet->ids;
+	GList		*iter = itemSet->ids;
+	itemArenaPtr	arena = item_arena_new ();
 	
 	while(iter) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+		itemPtr item = item_arena_load (arena, GPOINTER_TO_UINT (iter->data));
 		if (item) {
 			(*callback) (item);
 			item_unload (item);
 		}
 		iter = g_list_next (iter);
 	}
+
+	item_arena_free (arena);
 }
 
 // FIXME: this ought to be a subscription property!
@@ -153,9 +156,9 @@ itemset_generic_merge_check (GList *items, itemPtr newItem, gint maxChecks, gboo
 				
 				/* don't use item_set_description as it does some unwanted length handling 
 				   and we want to enforce the new description */
-				g_free (oldItem->description);
-				oldItem->description = newItem->description;
+				item_replace_description (oldItem, newItem->description);
 				newItem->description = NULL;
+				oldItem->sanitized = newItem->sanitized;
 				
 				oldItem->time = newItem->time;
 				oldItem->updateStatus = TRUE;
@@ -210,9 +213,9 @@ itemset_merge_item (itemSetPtr itemSet, GList *items, itemPtr item, gint maxChec
 	if (merge) {
 		g_assert (!item->nodeId);
 		g_assert (!item->id);
-		item->nodeId = g_strdup (itemSet->nodeId);
+		item->nodeId = g_intern_string (itemSet->nodeId);
 		if (!item->parentNodeId)
-			item->parentNodeId = g_strdup (itemSet->nodeId);
+			item->parentNodeId = g_intern_string (itemSet->nodeId);
 		
 		/* step 1: write item to DB */
 		db_item_update (item);
@@ -223,21 +226,11 @@ itemset_merge_item (itemSetPtr itemSet, GList *items, itemPtr item, gint maxChec
 		debug3 (DEBUG_UPDATE, "-> added \"%s\" (id=%d) to item set %p...", item_get_title (item), item->id, itemSet);
 		
 		/* step 3: duplicate detection, mark read if it is a duplicate */
-		if (item->validGuid) {
-			GSList	*iter, *duplicates;
-
-			duplicates = iter = db_item_get_duplicates (item->sourceId);
-			while (iter) {
-				debug1 (DEBUG_UPDATE, "-> duplicate guid exists: #%lu", GPOINTER_TO_UINT (iter->data));
-				iter = g_slist_next (iter);
-			}
-			
-			if (g_slist_length (duplicates) > 1) {
-				item->readStatus = TRUE;	/* no unread counting... */
-				item->popupStatus = FALSE;	/* no notification... */
-			}
-			
-			g_slist_free (duplicates);
+		/* (the duplicate count was updated when writing the item) */
+		if (item->validGuid && (item->duplicates > 0)) {
+			debug1 (DEBUG_UPDATE, "-> %u duplicate(s) with the same guid exist", item->duplicates);
+			item->readStatus = TRUE;	/* no unread counting... */
+			item->popupStatus = FALSE;	/* no notification... */
 		}
 
 		/* step 4: Check item for new enclosures to download */
@@ -251,6 +244,9 @@ itemset_merge_item (itemSetPtr itemSet, GList *items, itemPtr item, gint maxChec
 				enclosure_free (enc);
 			}
 		}
+
+		/* step 5: download the item images in the background */
+		image_cache_fetch_item (item);
 	} else {
 		debug2 (DEBUG_UPDATE, "-> not adding \"%s\" to node id \"%s\"...", item_get_title (item), itemSet->nodeId);
 		item_unload (item);
@@ -292,8 +288,9 @@ itemset_sort_by_date (gconstpointer a, gconstpointer b)
 guint
 itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gboolean markAsRead)
 {
-	GList	*iter, *droppedItems = NULL, *items = NULL;
-	guint	max, length, toBeDropped, newCount = 0, flagCount = 0;
+	GList		*iter, *droppedItems = NULL, *items = NULL;
+	guint		max, length, toBeDropped, newCount = 0, flagCount = 0;
+	itemArenaPtr	arena;
 
 	debug_start_measurement (DEBUG_UPDATE);
 	
@@ -308,10 +305,13 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 	length = g_list_length (list);
 	max = itemset_get_max_item_count (itemSet);
 
-	/* Preload all items for flag counting and later merging comparison */
+	/* Preload all items for flag counting and later merging comparison.
+	   The preloaded items do not survive the merging, so they are
+	   allocated from an arena that is dropped at once in the end. */
+	arena = item_arena_new ();
 	iter = itemSet->ids;
 	while (iter) {
-		itemPtr item = item_load (GPOINTER_TO_UINT (iter->data));
+		itemPtr item = item_arena_load (arena, GPOINTER_TO_UINT (iter->data));
 		if (item) {
 			items = g_list_append (items, item);
 			if (item->flagStatus)
@@ -377,6 +377,9 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 		
 		if (markAsRead)
 			item->readStatus = TRUE;
+
+		/* strip before comparing, as the old items are stored stripped */
+		item_sanitize_description (item);
 			
 		if (itemset_merge_item (itemSet, items, item, length, allowUpdates)) {
 			newCount++;
@@ -386,8 +389,6 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 	}
 	g_list_free (list);
 
-	vfolder_foreach (node_update_counters);
-	
 	debug1(DEBUG_UPDATE, "added %d new items", newCount);
 	
 	/* 4. Apply cache limit for effective item set size
@@ -426,6 +427,7 @@ itemset_merge_items (itemSetPtr itemSet, GList *list, gboolean allowUpdates, gbo
 		debug0 (DEBUG_CACHE, "Fatal: Item merging bug! Resulting item list is too long! Cache limit does not work. This is a severe program bug!");
 	
 	g_list_free (items);
+	item_arena_free (arena);
 	
 	debug_end_measurement (DEBUG_UPDATE, "merge itemset");
 	
@@ -454,6 +456,44 @@ itemset_check_item (itemSetPtr itemSet, itemPtr item)
 	return result;
 }
 
+/* Evaluates the rules like itemset_check_item() does, but using
+   three-valued logic: only the read state rule can be decided,
+   the result of all other rules is unknown. */
+itemSetReadMatch
+itemset_check_read_items (itemSetPtr itemSet)
+{
+	itemSetReadMatch	result = ITEMSET_READ_ITEMS_MATCH;
+	GSList			*iter;
+
+	for (iter = itemSet->rules; iter; iter = g_slist_next (iter)) {
+		if (g_str_equal (((rulePtr)iter->data)->ruleInfo->ruleId, "unread"))
+			break;
+	}
+	if (!iter)
+		return ITEMSET_READ_STATE_IRRELEVANT;
+
+	iter = itemSet->rules;
+	while (iter) {
+		rulePtr			rule = (rulePtr) iter->data;
+		itemSetReadMatch	ruleResult = ITEMSET_READ_ITEMS_UNKNOWN;
+
+		if (g_str_equal (rule->ruleInfo->ruleId, "unread"))
+			ruleResult = rule->additive?ITEMSET_READ_ITEMS_DONT_MATCH:ITEMSET_READ_ITEMS_MATCH;
+
+		if ((ITEMSET_READ_ITEMS_DONT_MATCH == result) || (ITEMSET_READ_ITEMS_DONT_MATCH == ruleResult))
+			result = ITEMSET_READ_ITEMS_DONT_MATCH;
+		else if (ITEMSET_READ_ITEMS_UNKNOWN == ruleResult)
+			result = ITEMSET_READ_ITEMS_UNKNOWN;
+
+		if (itemSet->anyMatch && (ITEMSET_READ_ITEMS_DONT_MATCH != result))
+			return result;
+
+		iter = g_slist_next (iter);
+	}
+
+	return result;
+}
+
 void
 itemset_add_rule (itemSetPtr itemSet,
                   const gchar *ruleId,
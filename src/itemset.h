@@ -74,6 +74,26 @@ guint itemset_merge_items(itemSetPtr itemSet, GList *items, gboolean allowUpdate
  */
 gboolean itemset_check_item (itemSetPtr itemSet, itemPtr item);
 
+/** results of itemset_check_read_items() */
+typedef enum {
+	ITEMSET_READ_STATE_IRRELEVANT,	/**< the rules do not depend on the item read state */
+	ITEMSET_READ_ITEMS_MATCH,	/**< every read item matches the rules */
+	ITEMSET_READ_ITEMS_DONT_MATCH,	/**< no read item matches the rules */
+	ITEMSET_READ_ITEMS_UNKNOWN	/**< read items need to be checked one by one */
+} itemSetReadMatch;
+
+/**
+ * Checks how the rules of the given item set apply to read items
+ * without knowing anything else about the items. Allows updating 
+ * search folders after bulk read state changes without checking
+ * each item.
+ *
+ * @param itemSet	the itemSet
+ *
+ * @returns the matching result
+ */
+itemSetReadMatch itemset_check_read_items (itemSetPtr itemSet);
+
 /**
  * Method that creates and adds a rule to an item set. To be used
  * on loading time, when creating searches or when editing
@@ -41,7 +41,9 @@
 #include "db.h"
 #include "dbus.h"
 #include "debug.h"
+#include "favicon.h"
 #include "feedlist.h"
+#include "image_cache.h"
 #include "social.h"
 #include "update.h"
 #include "xml.h"
@@ -239,6 +241,7 @@ main (int argc, char *argv[])
 	/* order is important! */
 	db_init ();			/* initialize sqlite */
 	xml_init ();			/* initialize libxml2 */
+	image_cache_init ();		/* needs the DB */
 #ifdef HAVE_LIBNOTIFY
 	notification_plugin_register (&libnotify_plugin);
 #endif
@@ -307,6 +310,8 @@ on_shutdown (gpointer user_data)
 
 	/* order is important ! */
 	update_deinit ();
+	image_cache_deinit ();
+	favicon_deinit ();
 	db_deinit ();
 	social_free ();
 
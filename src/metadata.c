@@ -30,15 +30,27 @@
 /* Metadata in Liferea are ordered lists of key/value list pairs. Both 
    feed list nodes and items can have a list of metadata assigned. Metadata
    date values are always text values but maybe of different type depending
-   on their usage type. */
+   on their usage type.
 
-static GHashTable *metadataTypes = NULL;	/**< hash table with all registered meta data types */
+   Metadata keys are interned as small integer ids, so a metadata list
+   is a flat array of key id/value list pairs and key comparisons do
+   not need string compares. */
+
+static GHashTable *metadataTypes = NULL;	/**< hash table mapping key names to key ids */
+static GPtrArray *metadataKeyNames = NULL;	/**< key names indexed by key id */
+static GArray *metadataKeyTypes = NULL;		/**< key types indexed by key id (0 if unregistered) */
 
 struct pair {
-	gchar		*strid;		/** metadata type id */
+	guint		key;		/** interned metadata type id */
 	GSList		*data;		/** list of metadata values */
 };
 
+struct metadataList {
+	guint		length;		/** number of used pairs */
+	guint		size;		/** number of allocated pairs */
+	struct pair	pairs[];
+};
+
 /* register metadata types to check validity on adding */
 static void
 metadata_init (void)
@@ -46,6 +58,12 @@ metadata_init (void)
 	g_assert (NULL == metadataTypes);
 	
 	metadataTypes = g_hash_table_new (g_str_hash, g_str_equal);
+	metadataKeyNames = g_ptr_array_new ();
+	metadataKeyTypes = g_array_new (FALSE, TRUE, sizeof (gint));
+
+	/* key id 0 is reserved for "no key" */
+	g_ptr_array_add (metadataKeyNames, NULL);
+	g_array_set_size (metadataKeyTypes, 1);
 	
 	/* generic types */
 	metadata_type_register ("author",		METADATA_TYPE_HTML);
@@ -111,38 +129,60 @@ metadata_init (void)
 	return;
 }
 
+/* Returns the key id for a key name, interning the name if necessary */
+static guint
+metadata_key_intern (const gchar *name)
+{
+	guint	key;
+
+	if (!metadataTypes)
+		metadata_init ();
+
+	key = GPOINTER_TO_UINT (g_hash_table_lookup (metadataTypes, name));
+	if (0 == key) {
+		key = metadataKeyNames->len;
+		name = g_intern_string (name);
+		g_ptr_array_add (metadataKeyNames, (gpointer)name);
+		g_array_set_size (metadataKeyTypes, key + 1);
+		g_hash_table_insert (metadataTypes, (gpointer)name, GUINT_TO_POINTER (key));
+	}
+
+	return key;
+}
+
 void
 metadata_type_register (const gchar *name, gint type)
+{
+	guint	key = metadata_key_intern (name);
+
+	g_array_index (metadataKeyTypes, gint, key) = type;
+}
+
+guint
+metadata_type_get_key (const gchar *strid)
 {
 	if (!metadataTypes)
-		metadata_init ();	
-	
-	g_hash_table_insert (metadataTypes, (gpointer)name, GINT_TO_POINTER (type));
+		metadata_init ();
+
+	return GPOINTER_TO_UINT (g_hash_table_lookup (metadataTypes, strid));
 }
 
 gboolean
 metadata_is_type_registered (const gchar *strid)
 {
-	if (!metadataTypes)
-		metadata_init ();
+	guint	key = metadata_type_get_key (strid);
 
-	if (g_hash_table_lookup (metadataTypes, strid))
-		return TRUE;
-	else
-		return FALSE;
+	return (0 != key) && (0 != g_array_index (metadataKeyTypes, gint, key));
 }
 
 static gint
-metadata_get_type (const gchar *name)
+metadata_get_type (guint key)
 {
 	gint	type;
-	
-	if (!metadataTypes)
-		metadata_init ();
 
-	type = GPOINTER_TO_INT (g_hash_table_lookup (metadataTypes, (gpointer)name));
+	type = g_array_index (metadataKeyTypes, gint, key);
 	if (0 == type)
-		g_warning ("Unknown metadata type: %s, please report this Liferea bug!", name);
+		g_warning ("Unknown metadata type: %s, please report this Liferea bug!", (gchar *)g_ptr_array_index (metadataKeyNames, key));
 	
 	return type;
 }
@@ -156,18 +196,58 @@ metadata_value_cmp (gconstpointer a, gconstpointer b)
 	return 1;
 }
 
-GSList *
-metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
+static struct pair *
+metadata_list_find (metadataListPtr metadata, guint key)
+{
+	guint	i;
+
+	if (!metadata)
+		return NULL;
+
+	for (i = 0; i < metadata->length; i++) {
+		if (metadata->pairs[i].key == key)
+			return &metadata->pairs[i];
+	}
+
+	return NULL;
+}
+
+/* Adds a new pair for the given key, grows the array if necessary */
+static struct pair *
+metadata_list_add_pair (metadataListPtr *metadata, guint key)
+{
+	struct pair	*p;
+
+	if (!*metadata) {
+		*metadata = g_malloc (sizeof (struct metadataList) + 4 * sizeof (struct pair));
+		(*metadata)->length = 0;
+		(*metadata)->size = 4;
+	} else if ((*metadata)->length == (*metadata)->size) {
+		(*metadata)->size *= 2;
+		*metadata = g_realloc (*metadata, sizeof (struct metadataList) + (*metadata)->size * sizeof (struct pair));
+	}
+
+	p = &(*metadata)->pairs[(*metadata)->length++];
+	p->key = key;
+	p->data = NULL;
+
+	return p;
+}
+
+metadataListPtr
+metadata_list_append (metadataListPtr metadata, const gchar *strid, const gchar *data)
 {
-	GSList		*iter = metadata;
 	gchar		*tmp, *checked_data = NULL;
 	struct pair 	*p;
+	guint		key;
 	
 	if (!data)
 		return metadata;
 	
+	key = metadata_key_intern (strid);
+
 	/* lookup type and check format */
-	switch (metadata_get_type (strid)) {
+	switch (metadata_get_type (key)) {
 		case METADATA_TYPE_TEXT:
 			/* No check because renderer will process further */
 			checked_data = g_strdup (data);
@@ -184,7 +264,7 @@ metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
 			checked_data = g_strchomp (checked_data);
 			break;
 		default:
-			g_warning ("Unknown metadata type: %s (id=%d), please report this Liferea bug! Treating as HTML.", strid, metadata_get_type (strid));
+			g_warning ("Unknown metadata type: %s (id=%d), please report this Liferea bug! Treating as HTML.", strid, metadata_get_type (key));
 		case METADATA_TYPE_HTML:
 			/* Needs to check for proper XHTML */
 			if (xhtml_is_well_formed (data)) {
@@ -200,83 +280,88 @@ metadata_list_append (GSList *metadata, const gchar *strid, const gchar *data)
 			break;
 	}
 	
-	while (iter) {
-		p = (struct pair*)iter->data; 
-		if (g_str_equal (p->strid, strid)) {
-			/* Avoid duplicate values */
-			if (NULL == g_slist_find_custom (p->data, checked_data, metadata_value_cmp))
-				p->data = g_slist_append (p->data, checked_data);
-			return metadata;
-		}
-		iter = iter->next;
+	p = metadata_list_find (metadata, key);
+	if (p) {
+		/* Avoid duplicate values */
+		if (NULL == g_slist_find_custom (p->data, checked_data, metadata_value_cmp))
+			p->data = g_slist_append (p->data, checked_data);
+		else
+			g_free (checked_data);
+		return metadata;
 	}
-	p = g_new (struct pair, 1);
-	p->strid = g_strdup (strid);
+
+	p = metadata_list_add_pair (&metadata, key);
 	p->data = g_slist_append (NULL, checked_data);
-	metadata = g_slist_append (metadata, p);
 	return metadata;
 }
 
 void
-metadata_list_set (GSList **metadata, const gchar *strid, const gchar *data)
+metadata_list_set (metadataListPtr *metadata, const gchar *strid, const gchar *data)
 {
-	GSList	*iter = *metadata;
-	struct pair *p;
+	struct pair	*p;
+	guint		key = metadata_key_intern (strid);
 	
-	while (iter) {
-		p = (struct pair*)iter->data; 
-		if (g_str_equal (p->strid, strid)) {
-			if (p->data) {
-				/* exchange old value */
-				g_free (((GSList *)p->data)->data);
-				((GSList *)p->data)->data = g_strdup (data);
-			} else {
-				p->data = g_slist_append (p->data, g_strdup (data));
-			}
-			return;
+	p = metadata_list_find (*metadata, key);
+	if (p) {
+		if (p->data) {
+			/* exchange old value */
+			g_free (((GSList *)p->data)->data);
+			((GSList *)p->data)->data = g_strdup (data);
+		} else {
+			p->data = g_slist_append (p->data, g_strdup (data));
 		}
-		iter = iter->next;
+		return;
 	}
-	p = g_new (struct pair, 1);
-	p->strid = g_strdup (strid);
+
+	p = metadata_list_add_pair (metadata, key);
 	p->data = g_slist_append (NULL, g_strdup (data));
-	*metadata = g_slist_append (*metadata, p);
 }
 
 void
-metadata_list_foreach (GSList *metadata, metadataForeachFunc func, gpointer user_data)
+metadata_list_foreach (metadataListPtr metadata, metadataForeachFunc func, gpointer user_data)
 {
-	GSList	*list = metadata;
-	guint	index = 0;
+	guint	i, index = 0;
 	
-	while (list) {
-		struct pair *p = (struct pair*)list->data; 
+	if (!metadata)
+		return;
+
+	for (i = 0; i < metadata->length; i++) {
+		struct pair *p = &metadata->pairs[i];
+		const gchar *strid = g_ptr_array_index (metadataKeyNames, p->key);
 		GSList *values = (GSList *)p->data;
 		while (values) {
 			index++;
-			(*func)(p->strid, values->data, index, user_data);
+			(*func)(strid, values->data, index, user_data);
 			values = g_slist_next (values);
 		}
-		list = list->next;
 	}
 }
 
 GSList *
-metadata_list_get_values (GSList *metadata, const gchar *strid)
+metadata_list_get_values_by_key (metadataListPtr metadata, guint key)
 {
-	GSList *list = metadata;
-	
-	while (list) {
-		struct pair *p = (struct pair*)list->data; 
-		if (g_str_equal (p->strid, strid))
-			return p->data;
-		list = list->next;
-	}
-	return NULL;
+	struct pair	*p = metadata_list_find (metadata, key);
+
+	return p?p->data:NULL;
+}
+
+GSList *
+metadata_list_get_values (metadataListPtr metadata, const gchar *strid)
+{
+	guint	key;
+
+	if (!metadata)
+		return NULL;
+
+	key = metadata_type_get_key (strid);
+	if (!key)
+		return NULL;
+
+	return metadata_list_get_values_by_key (metadata, key);
 }
 
 const gchar *
-metadata_list_get (GSList *metadata, const gchar *strid)
+metadata_list_get (metadataListPtr metadata, const gchar *strid)
 {
 	GSList	*values;
 	
@@ -285,64 +370,78 @@ metadata_list_get (GSList *metadata, const gchar *strid)
 
 }
 
-GSList *
-metadata_list_copy (GSList *list)
+metadataListPtr
+metadata_list_copy (metadataListPtr list)
 {
-	GSList		*copy = NULL;
-	GSList		*iter2, *iter = list;
-	struct pair	*p;
+	metadataListPtr	copy = NULL;
+	GSList		*iter;
+	guint		i;
 	
-	while (iter) {
-		p = (struct pair*)iter->data;
-		iter2 = p->data;
-		while (iter2) {
-			copy = metadata_list_append (copy, p->strid, iter2->data);
-			iter2 = iter2->next;
+	if (!list)
+		return NULL;
+
+	for (i = 0; i < list->length; i++) {
+		struct pair *p = metadata_list_add_pair (&copy, list->pairs[i].key);
+		iter = list->pairs[i].data;
+		while (iter) {
+			p->data = g_slist_prepend (p->data, g_strdup (iter->data));
+			iter = iter->next;
 		}
-		iter = iter->next;
+		p->data = g_slist_reverse (p->data);
 	}
 	
 	return copy;
 }
 
 void
-metadata_list_free (GSList *metadata)
+metadata_list_free (metadataListPtr metadata)
 {
-	GSList		*list2, *iter2, *iter = metadata;
-	struct pair	*p;
+	guint	i;
 	
-	while (iter) {
-		p = (struct pair*)iter->data;
-		list2 = p->data;
-		iter2 = list2;
-		while (iter2) {
-			g_free (iter2->data);
-			iter2 = iter2->next;
+	if (!metadata)
+		return;
+
+	for (i = 0; i < metadata->length; i++) {
+		GSList *iter = metadata->pairs[i].data;
+		while (iter) {
+			g_free (iter->data);
+			iter = iter->next;
 		}
-		g_slist_free (list2);
-		g_free (p->strid);
-		g_free (p);
-		iter = iter->next;
+		g_slist_free (metadata->pairs[i].data);
 	}
-	g_slist_free (metadata);
+	g_free (metadata);
 }
 
-void
-metadata_add_xml_nodes (GSList *metadata, xmlNodePtr parentNode)
+static void
+metadata_list_serialize (metadataListPtr metadata, xmlNodePtr parentNode, GString *key)
 {
-	GSList *list = metadata;
-	xmlNodePtr attribute;
-	xmlNodePtr metadataNode = xmlNewChild (parentNode, NULL, "attributes", NULL);
+	xmlNodePtr	attribute;
+	xmlNodePtr	metadataNode = xml_add_child (parentNode, key, "attributes");
+	guint		i;
 	
-	while (list) {
-		struct pair *p = (struct pair*)list->data; 
+	if (!metadata)
+		return;
+
+	for (i = 0; i < metadata->length; i++) {
+		struct pair *p = &metadata->pairs[i];
+		const gchar *strid = g_ptr_array_index (metadataKeyNames, p->key);
 		GSList *list2 = p->data;
 		while (list2) {
-			attribute = xmlNewTextChild (metadataNode, NULL, "attribute", list2->data);
-			xmlNewProp (attribute, "name", p->strid);
+			attribute = xml_add_text_child (metadataNode, key, "attribute", list2->data);
+			xml_add_attribute (attribute, key, "name", strid);
 			list2 = list2->next;
 		}
-		list = list->next;
 	}
 }
 
+void
+metadata_add_xml_nodes (metadataListPtr metadata, xmlNodePtr parentNode)
+{
+	metadata_list_serialize (metadata, parentNode, NULL);
+}
+
+void
+metadata_list_to_render_key (metadataListPtr metadata, GString *key)
+{
+	metadata_list_serialize (metadata, NULL, key);
+}
@@ -53,6 +53,9 @@ enum {
 	METADATA_TYPE_HTML = 3	/**< metadata is XHTML content and valid to be embedded in XML */
 };
 
+/** a metadata list, NULL is a valid empty list */
+typedef struct metadataList *metadataListPtr;
+
 /**
  * Register a metadata type. This allows type specific
  * sanity handling and detecting invalid metadata.
@@ -62,6 +65,17 @@ enum {
  */
 void metadata_type_register (const gchar *name, gint);
 
+/**
+ * Returns the interned key id of a metadata type. Key ids
+ * are stable for the runtime of the program and can be used
+ * to avoid repeated string lookups.
+ *
+ * @param strid		the metadata type identifier
+ *
+ * @returns the key id (or 0 if the type is unknown)
+ */
+guint metadata_type_get_key (const gchar *strid);
+
 /**
  * Checks whether a metadata type is registered
  *
@@ -81,7 +95,7 @@ gboolean metadata_is_type_registered (const gchar *strid);
  *
  * @returns the changed meta data list
  */
-GSList * metadata_list_append(GSList *metadata, const gchar *strid, const gchar *data);
+metadataListPtr metadata_list_append (metadataListPtr metadata, const gchar *strid, const gchar *data);
 
 /** 
  * Sets (and overwrites if necessary) the value of a specific metadata type.
@@ -91,7 +105,7 @@ GSList * metadata_list_append(GSList *metadata, const gchar *strid, const gchar
  * @param strid		the metadata type identifier
  * @param data		data to add
  */
-void metadata_list_set(GSList **metadata, const gchar *strid, const gchar *data);
+void metadata_list_set (metadataListPtr *metadata, const gchar *strid, const gchar *data);
 
 /**
  * Returns the first value of a given type from a specified metadata list.
@@ -102,7 +116,7 @@ void metadata_list_set(GSList **metadata, const gchar *strid, const gchar *data)
  *
  * @returns the first value (or NULL)
  */
-const gchar * metadata_list_get(GSList *metadata, const gchar *strid);
+const gchar * metadata_list_get (metadataListPtr metadata, const gchar *strid);
 
 /** 
  * Definition of metadata foreach function 
@@ -121,7 +135,7 @@ typedef void	(*metadataForeachFunc)	(const gchar *key, const gchar *value, guint
  * @param func		callback function
  * @param user_data	data to be passed to func
  */
-void metadata_list_foreach(GSList *metadata, metadataForeachFunc func, gpointer user_data);
+void metadata_list_foreach (metadataListPtr metadata, metadataForeachFunc func, gpointer user_data);
 
 /**
  * Returns a list of all values of a given type from a specified metadata list.
@@ -131,7 +145,18 @@ void metadata_list_foreach(GSList *metadata, metadataForeachFunc func, gpointer
  *
  * @returns a list of values (or NULL)
  */
-GSList * metadata_list_get_values(GSList *metadata, const gchar *strid);
+GSList * metadata_list_get_values (metadataListPtr metadata, const gchar *strid);
+
+/**
+ * Like metadata_list_get_values() but takes a key id
+ * as returned by metadata_type_get_key().
+ *
+ * @param metadata	the metadata list
+ * @param key		the metadata key id
+ *
+ * @returns a list of values (or NULL)
+ */
+GSList * metadata_list_get_values_by_key (metadataListPtr metadata, guint key);
 
 /** 
  * Creates a copy of a given metadata list.
@@ -140,14 +165,14 @@ GSList * metadata_list_get_values(GSList *metadata, const gchar *strid);
  *
  * @returns the new list
  */
-GSList * metadata_list_copy(GSList *list);
+metadataListPtr metadata_list_copy (metadataListPtr list);
 
 /**
  * Frees all memory allocated by the given metadata list.
  *
  * @param metadata	the metadata list
  */
-void metadata_list_free(GSList *metadata);
+void metadata_list_free (metadataListPtr metadata);
 
 /**
  * Adds the given metadata list to a given XML document node.
@@ -156,6 +181,15 @@ void metadata_list_free(GSList *metadata);
  * @param metadata	the metadata list
  * @param parentNode	the XML node
  */
-void metadata_add_xml_nodes(GSList *metadata, xmlNodePtr parentNode);
+void metadata_add_xml_nodes (metadataListPtr metadata, xmlNodePtr parentNode);
+
+/**
+ * Appends everything metadata_add_xml_nodes() would serialize
+ * to the given render cache key.
+ *
+ * @param metadata	the metadata list
+ * @param key		the key to append to
+ */
+void metadata_list_to_render_key (metadataListPtr metadata, GString *key);
 
 #endif
@@ -63,17 +63,14 @@ newsbin_remove (nodePtr node)
 	feed_get_node_type()->remove(node);
 }
 
-static gchar *
-newsbin_render (nodePtr node)
+static void
+newsbin_render (nodePtr node, GString *output)
 {
-	gchar		*output = NULL;
 	xmlDocPtr	doc;
 
 	doc = feed_to_xml(node, NULL);
-	output = render_xml(doc, "newsbin", NULL);
+	render_xml_append (output, doc, "newsbin", NULL);
 	xmlFreeDoc(doc);
-
-	return output;
 }
 
 static gboolean
@@ -116,8 +113,8 @@ on_popup_copy_to_newsbin (gpointer data)
 	item = itemlist_get_selected();
 	if(item) {
 		copy = item_copy(item);
-		copy->nodeId = newsbin->id;	/* necessary to become independent of original item */
-		copy->parentNodeId = g_strdup (item->nodeId);
+		copy->nodeId = g_intern_string (newsbin->id);	/* necessary to become independent of original item */
+		copy->parentNodeId = item->nodeId;
 		
 		/* To avoid item doubling in vfolders we reset
 		   simple vfolder match attributes */
@@ -25,6 +25,7 @@
 #include "conf.h"
 #include "db.h"
 #include "debug.h"
+#include "favicon.h"
 #include "itemlist.h"
 #include "itemset.h"
 #include "item_state.h"
@@ -40,6 +41,9 @@
 
 static GHashTable *nodes = NULL;	/**< node id -> node lookup table */
 
+static GSList	*recountNodes = NULL;	/**< nodes scheduled for recounting */
+static guint	recountId = 0;		/**< idle source id of the recount */
+
 #define NODE_ID_LEN	7
 
 nodePtr
@@ -186,6 +190,8 @@ node_free (nodePtr node)
 	g_assert (NULL == node->children);
 	
 	g_hash_table_remove (nodes, node->id);
+
+	recountNodes = g_slist_remove (recountNodes, node);
 	
 	update_job_cancel_by_owner (node);
 
@@ -210,6 +216,9 @@ node_calc_counters (nodePtr node)
 	node_foreach_child (node, node_calc_counters);
 	
 	NODE_TYPE (node)->update_counters (node);
+
+	/* a scheduled recount is no longer necessary */
+	node->needsRecount = FALSE;
 }
 
 static void
@@ -253,6 +262,106 @@ node_update_counters (nodePtr node)
 		node_update_parent_counters (node->parent);
 }
 
+static gint
+node_get_depth (nodePtr node)
+{
+	gint	depth = 0;
+
+	while ((node = node->parent))
+		depth++;
+
+	return depth;
+}
+
+static gint
+node_compare_depth (gconstpointer a, gconstpointer b)
+{
+	return node_get_depth ((nodePtr)b) - node_get_depth ((nodePtr)a);
+}
+
+static gboolean
+node_update_counters_idle (gpointer user_data)
+{
+	GHashTable	*parents;
+	GList		*sorted, *iter;
+	GSList		*list;
+	gboolean	changed = FALSE;
+
+	debug_start_measurement (DEBUG_GUI);
+
+	list = recountNodes;
+	recountNodes = NULL;
+	recountId = 0;
+
+	/* 1. Recount all scheduled nodes and collect their parents */
+	parents = g_hash_table_new (g_direct_hash, g_direct_equal);
+	while (list) {
+		nodePtr		node = (nodePtr)list->data;
+		nodePtr		parent;
+		guint		oldUnreadCount = node->unreadCount;
+		guint		oldItemCount = node->itemCount;
+
+		/* might have been recounted synchronously in the meantime */
+		if (node->needsRecount) {
+			node_calc_counters (node);
+
+			if ((oldUnreadCount != node->unreadCount) ||
+			    (oldItemCount != node->itemCount)) {
+				ui_node_update (node->id);
+				changed = TRUE;
+			}
+		}
+
+		if (!IS_VFOLDER (node)) {
+			for (parent = node->parent; parent; parent = parent->parent)
+				g_hash_table_insert (parents, parent, parent);
+		}
+
+		list = g_slist_delete_link (list, list);
+	}
+
+	/* 2. Update each parent once, deepest nodes first as parent
+	      nodes usually just add all child unread counters */
+	sorted = g_list_sort (g_hash_table_get_keys (parents), node_compare_depth);
+	for (iter = sorted; iter; iter = g_list_next (iter)) {
+		nodePtr	node = (nodePtr)iter->data;
+		guint	old = node->unreadCount;
+
+		NODE_TYPE (node)->update_counters (node);
+
+		if (old != node->unreadCount) {
+			ui_node_update (node->id);
+			changed = TRUE;
+		}
+	}
+	g_list_free (sorted);
+	g_hash_table_destroy (parents);
+
+	/* 3. Update the global statistics only once */
+	if (changed) {
+		ui_tray_update ();
+		liferea_shell_update_unread_stats ();
+	}
+
+	debug_end_measurement (DEBUG_GUI, "deferred counter update");
+
+	return FALSE;
+}
+
+void
+node_schedule_update_counters (nodePtr node)
+{
+	if (!node || node->needsRecount)
+		return;
+
+	node->needsRecount = TRUE;
+	recountNodes = g_slist_prepend (recountNodes, node);
+
+	/* run before the next redraw to update all widgets in the same frame */
+	if (!recountId)
+		recountId = g_idle_add_full (G_PRIORITY_HIGH_IDLE, node_update_counters_idle, NULL, NULL);
+}
+
 void
 node_update_favicon (nodePtr node)
 {
@@ -272,26 +381,44 @@ node_get_itemset (nodePtr node)
 	return NODE_TYPE (node)->load (node);
 }
 
+static void
+node_reset_unread_count (nodePtr node)
+{
+	if (node->unreadCount > 0) {
+		node->unreadCount = 0;
+		node->needsUpdate = TRUE;
+		ui_node_update (node->id);
+	}
+
+	if (node->children)
+		node_foreach_child (node, node_reset_unread_count);
+}
+
 void
 node_mark_all_read (nodePtr node)
 {
 	if (!node)
 		return;
 
-	if ((node->unreadCount > 0) || (IS_VFOLDER (node))) {
-		itemset_mark_read (node);
-		node->unreadCount = 0;
-		node->needsUpdate = TRUE;
+	/* marks the items of all child nodes too */
+	itemset_mark_read (node);
+
+	/* The whole subtree is read now, so its counters are reset
+	   right away without recounting. The parent nodes are
+	   recounted once from the idle counter update. */
+	node_reset_unread_count (node);
+	if (node->parent) {
+		node_schedule_update_counters (node);
+	} else {
+		ui_tray_update ();
+		liferea_shell_update_unread_stats ();
 	}
-		
-	if (node->children)
-		node_foreach_child (node, node_mark_all_read);
 }
 
-gchar *
-node_render(nodePtr node)
+void
+node_render (nodePtr node, GString *output)
 {
-	return NODE_TYPE (node)->render (node);
+	NODE_TYPE (node)->render (node, output);
 }
 
 /* import callbacks and helper functions */
@@ -366,17 +493,14 @@ node_to_xml (nodePtr node)
 	return doc;
 }
 
-gchar *
-node_default_render (nodePtr node)
+void
+node_default_render (nodePtr node, GString *output)
 {
-	gchar		*result;
 	xmlDocPtr	doc;
 
 	doc = node_to_xml (node);
-	result = render_xml (doc, NODE_TYPE(node)->id, NULL);	
+	render_xml_append (output, doc, NODE_TYPE(node)->id, NULL);	
 	xmlFreeDoc (doc);
-		
-	return result;
 }
 
 /* helper functions to be used with node_foreach* */
@@ -408,6 +532,7 @@ node_set_icon (nodePtr node, gpointer icon)
 	if (node->icon) 
 		g_object_unref (node->icon);
 	node->icon = icon;
+	node->iconDeferred = FALSE;
 	
 	g_free (node->iconFile);
 	
@@ -417,11 +542,27 @@ node_set_icon (nodePtr node, gpointer icon)
 		node->iconFile = g_build_filename (PACKAGE_DATA_DIR, PACKAGE, "pixmaps", "default.png", NULL);
 }
 
+void
+node_set_icon_deferred (nodePtr node)
+{
+	node_set_icon (node, NULL);
+	node->iconDeferred = TRUE;
+}
+
+gpointer
+node_get_favicon (nodePtr node)
+{
+	if (node->iconDeferred)
+		node_set_icon (node, favicon_load_from_cache (node->id));
+
+	return node->icon;
+}
+
 /** determines the nodes favicon or default icon */
 gpointer
 node_get_icon (nodePtr node)
 {
-	if (!node->icon)
+	if (!node_get_favicon (node))
 		return (gpointer) NODE_TYPE(node)->icon;
 
 	return node->icon;
@@ -430,6 +571,8 @@ node_get_icon (nodePtr node)
 const gchar *
 node_get_favicon_file (nodePtr node)
 {
+	node_get_favicon (node);
+
 	return node->iconFile;
 }
 
@@ -58,6 +58,7 @@ typedef struct node {
 
 	gchar			*title;		/**< the label of the node in the feed list */
 	gpointer		icon;		/**< pointer to pixmap, if there is a favicon */
+	gboolean		iconDeferred;	/**< TRUE if the favicon is still to be loaded from the favicon cache */
 	gboolean		available;	/**< availability of this node (usually the last downloading state) */
 	gboolean		expanded;	/**< expansion state (for nodes with childs) */
 
@@ -71,7 +72,7 @@ typedef struct node {
 	
 	/* current state of this node */	
 	gboolean	needsUpdate;	/**< if TRUE: the item list has changed and the nodes feed list representation needs to be updated */
-	gboolean	needsRecount;	/**< if TRUE: the number of unread/total items is currently unknown and needs recounting */
+	gboolean	needsRecount;	/**< if TRUE: the number of unread/total items is currently unknown and the node is scheduled for recounting */
 
 } *nodePtr;
 
@@ -206,6 +207,17 @@ void node_set_title(nodePtr node, const gchar *title);
  */
 void node_update_counters(nodePtr node);
 
+/**
+ * Schedules a deferred update of the item counters of the given 
+ * node. All scheduled updates are coalesced and processed in one 
+ * pass from an idle callback, updating each parent node and the
+ * global unread statistics only once. This method ensures 
+ * propagation to parent folders.
+ *
+ * @param node	the node
+ */
+void node_schedule_update_counters(nodePtr node);
+
 /**
  * Recursively marks all items of the given node as read.
  *
@@ -221,6 +233,26 @@ void node_mark_all_read(nodePtr node);
  */
 void node_set_icon(nodePtr node, gpointer icon);
 
+/**
+ * Assigns the cached favicon to the node, but defers loading
+ * it until it is first needed (e.g. when the node's feed list
+ * row is rendered). Used during feed list import, where most
+ * nodes are not visible yet.
+ *
+ * @param node		the node
+ */
+void node_set_icon_deferred(nodePtr node);
+
+/**
+ * Returns the favicon of the given node, loading it
+ * from the favicon cache if it was deferred.
+ *
+ * @param node		the node
+ *
+ * @returns a pixmap or NULL if there is no favicon
+ */
+gpointer node_get_favicon(nodePtr node);
+
 /**
  * Returns an appropriate icon for the given node. If the node
  * is unavailable the "unavailable" icon will be returned. If
@@ -279,10 +311,9 @@ void node_free(nodePtr node);
  * with the same name as the node type id.
  *
  * @param node		the node to render
- *
- * @returns XHTML string
+ * @param output	buffer to append the XHTML to
  */
-gchar * node_default_render(nodePtr node);
+void node_default_render (nodePtr node, GString *output);
 
 /**
  * Saves the given node to cache.
@@ -304,11 +335,10 @@ itemSetPtr node_get_itemset(nodePtr node);
 /**
  * Node content rendering
  *
- * @param node	the node
- *
- * @returns string with node rendered in HTML
+ * @param node		the node
+ * @param output	buffer to append the node rendered in HTML to
  */
-gchar * node_render(nodePtr node);
+void node_render (nodePtr node, GString *output);
 
 /**
  * Called when updating favicons is requested.
@@ -63,7 +63,7 @@ typedef struct nodeType {
 	void 		(*save)			(nodePtr node);
 	void		(*update_counters)	(nodePtr node);
 	void		(*remove)		(nodePtr node);
-	gchar *		(*render)		(nodePtr node);
+	void		(*render)		(nodePtr node, GString *output);
 	gboolean	(*request_add)		(void);
 	void		(*request_properties)	(nodePtr node);
 	
@@ -28,6 +28,7 @@
 #include <libxslt/xsltInternals.h>
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
+#include <libxslt/imports.h>
 #include <locale.h>
 #include <string.h>
 
@@ -60,7 +61,7 @@ static renderParamPtr	langParams = NULL;	/* the current locale settings (for loc
 
 static GHashTable	*stylesheets = NULL;	/* XSLT stylesheet cache */
 
-static void
+void
 render_parameter_free (renderParamPtr paramSet)
 {
 	g_strfreev (paramSet->params);
@@ -299,60 +300,185 @@ render_get_css (gboolean externalCss)
 	return css->str;
 }
 
-gchar *
-render_xml (xmlDocPtr doc, const gchar *xsltName, renderParamPtr paramSet)
+static int
+render_output_write (void *context, const char *buffer, int len)
 {
-	gchar			*output = NULL;
+	g_string_append_len ((GString *)context, buffer, len);
+	return len;
+}
+
+/* Applies an already loaded stylesheet, does not access any global
+   state and therefore can be run in worker threads. Only the body
+   element of the result is serialized and appended to output. */
+static gboolean
+render_apply (GString *output, xsltStylesheetPtr xslt, const gchar *xsltName, xmlDocPtr doc, renderParamPtr paramSet)
+{
+	xsltStylesheetPtr	style;
 	xmlDocPtr		resDoc;
-	xsltStylesheetPtr	xslt;
 	xmlOutputBufferPtr	buf;
+	xmlNodePtr		body;
+	const xmlChar		*encoding = NULL;
+	gint			indent = -1;
+	gsize			len = output->len;
 	
-	xslt = render_load_stylesheet(xsltName);
-	if (!xslt)
-		return NULL;
-
-	if (!paramSet)
-		paramSet = render_parameter_new ();
-	render_parameter_add (paramSet, "pixmapsDir='file://" PACKAGE_DATA_DIR G_DIR_SEPARATOR_S PACKAGE G_DIR_SEPARATOR_S "pixmaps" G_DIR_SEPARATOR_S "'");
-
 	resDoc = xsltApplyStylesheet (xslt, doc, (const gchar **)paramSet->params);
+	render_parameter_free (paramSet);
 	if (!resDoc) {
 		g_warning ("fatal: applying rendering stylesheet (%s) failed!", xsltName);
-		return NULL;
+		return FALSE;
 	}
 	
 	/* for debugging use: xsltSaveResultToFile(stdout, resDoc, xslt); */
 	
-	/* save results into return string */
-	buf = xmlAllocOutputBuffer (NULL);
-	if (-1 == xsltSaveResultTo(buf, resDoc, xslt))
+	buf = xmlOutputBufferCreateIO (render_output_write, NULL, output, NULL);
+
+	body = xhtml_find_body (resDoc);
+	if (body) {
+		/* Serialize the body like xsltSaveResultTo() does
+		   with the whole document, using the <xsl:output>
+		   settings of the stylesheet or its imports */
+		for (style = xslt; style; style = xsltNextImport (style)) {
+			if (!encoding)
+				encoding = style->encoding;
+			if (-1 == indent)
+				indent = style->indent;
+		}
+		xmlNodeDumpOutput (buf, resDoc, body, 1, (1 == indent), (const gchar *)encoding);
+	} else if (-1 == xsltSaveResultTo (buf, resDoc, xslt)) {
 		g_warning ("fatal: retrieving result of rendering stylesheet failed (%s)!", xsltName);
-		
-	if (xmlBufferLength (buf->buffer) > 0)
-		output = xmlCharStrdup (xmlBufferContent(buf->buffer));
+	}
 
 	xmlOutputBufferClose (buf);
 	xmlFreeDoc (resDoc);
-	render_parameter_free (paramSet);
+
+	return (output->len > len);
+}
+
+static renderParamPtr
+render_add_default_parameters (renderParamPtr paramSet)
+{
+	if (!paramSet)
+		paramSet = render_parameter_new ();
+	render_parameter_add (paramSet, "pixmapsDir='file://" PACKAGE_DATA_DIR G_DIR_SEPARATOR_S PACKAGE G_DIR_SEPARATOR_S "pixmaps" G_DIR_SEPARATOR_S "'");
+
+	return paramSet;
+}
+
+gchar *
+render_xml (xmlDocPtr doc, const gchar *xsltName, renderParamPtr paramSet)
+{
+	GString	*output = g_string_new (NULL);
+
+	if (!render_xml_append (output, doc, xsltName, paramSet)) {
+		g_string_free (output, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (output, FALSE);
+}
+
+gboolean
+render_xml_append (GString *output, xmlDocPtr doc, const gchar *xsltName, renderParamPtr paramSet)
+{
+	xsltStylesheetPtr	xslt;
 	
-	if (output) {
-		gchar *tmp;
-		
-		/* Return only the body contents */
-		tmp = strstr (output, "<body");
-		if (tmp) {
-			tmp = g_strdup (tmp);
-			xmlFree (output);
-			output = tmp;
-			tmp = strstr (output, "</body>");
-			if (tmp) {
-				tmp += 7;
-				*tmp = 0;
-			}
-		}
+	xslt = render_load_stylesheet(xsltName);
+	if (!xslt) {
+		if (paramSet)
+			render_parameter_free (paramSet);
+		return FALSE;
+	}
+
+	return render_apply (output, xslt, xsltName, doc, render_add_default_parameters (paramSet));
+}
+
+#define RENDER_THREADS		4	/**< number of worker threads for render_xml_parallel() */
+#define RENDER_PARALLEL_MIN	8	/**< fewer documents are rendered without worker threads */
+
+/** worker threads shared by all render_xml_parallel() calls */
+static GThreadPool *renderPool = NULL;
+
+typedef struct renderJob {
+	xsltStylesheetPtr	xslt;
+	const gchar		*xsltName;
+	xmlDocPtr		doc;
+	renderParamPtr		paramSet;
+	gchar			*output;
+	GAsyncQueue		*done;		/**< receives the job when finished (or NULL) */
+} *renderJobPtr;
+
+static void
+render_job_run (gpointer data, gpointer user_data)
+{
+	renderJobPtr	job = (renderJobPtr)data;
+	GString		*output = g_string_new (NULL);
+
+	if (render_apply (output, job->xslt, job->xsltName, job->doc, job->paramSet))
+		job->output = g_string_free (output, FALSE);
+	else
+		g_string_free (output, TRUE);
+
+	if (job->done)
+		g_async_queue_push (job->done, job);
+}
+
+gchar **
+render_xml_parallel (xmlDocPtr *docs, renderParamPtr *paramSets, guint count, const gchar *xsltName)
+{
+	xsltStylesheetPtr	xslt;
+	struct renderJob	*jobs;
+	GAsyncQueue		*done = NULL;
+	gchar			**outputs;
+	guint			i;
+
+	outputs = g_new0 (gchar *, count);
+
+	/* Loading and caching the stylesheet is not thread-safe, a
+	   compiled stylesheet can be shared by the transformations. */
+	xslt = render_load_stylesheet (xsltName);
+	if (!xslt) {
+		for (i = 0; i < count; i++)
+			render_parameter_free (paramSets[i]);
+		return outputs;
 	}
 
-	return output;
+	debug_start_measurement (DEBUG_HTML);
+
+	/* Handing over a few documents costs more than it saves, e.g.
+	   for the items requested while scrolling a combined view. */
+	if (count >= RENDER_PARALLEL_MIN) {
+		if (!renderPool)
+			renderPool = g_thread_pool_new (render_job_run, NULL, RENDER_THREADS, FALSE, NULL);
+		done = g_async_queue_new ();
+	}
+
+	jobs = g_new0 (struct renderJob, count);
+	for (i = 0; i < count; i++) {
+		jobs[i].xslt = xslt;
+		jobs[i].xsltName = xsltName;
+		jobs[i].doc = docs[i];
+		jobs[i].paramSet = render_add_default_parameters (paramSets[i]);
+		jobs[i].done = done;
+		if (done)
+			g_thread_pool_push (renderPool, &jobs[i], NULL);
+		else
+			render_job_run (&jobs[i], NULL);
+	}
+
+	/* waits for all jobs to be finished */
+	if (done) {
+		for (i = 0; i < count; i++)
+			g_async_queue_pop (done);
+		g_async_queue_unref (done);
+	}
+
+	for (i = 0; i < count; i++)
+		outputs[i] = jobs[i].output;
+	g_free (jobs);
+
+	debug_end_measurement (DEBUG_HTML, "parallel rendering");
+
+	return outputs;
 }
 
 /* parameter handling */
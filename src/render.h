@@ -38,6 +38,33 @@ typedef struct renderParam {
  */
 gchar * render_xml (xmlDocPtr doc, const gchar *xsltName, renderParamPtr paramSet);
 
+/**
+ * Like render_xml(), but serializes the body of the result directly
+ * into the given output buffer instead of returning a new string.
+ *
+ * @param output	buffer to append the rendered XHTML to
+ * @param doc		XML source document
+ * @param xsltName	name of a stylesheet
+ * @param params	parameter/value string array (will be free'd)
+ *
+ * @returns TRUE if something was appended
+ */
+gboolean render_xml_append (GString *output, xmlDocPtr doc, const gchar *xsltName, renderParamPtr paramSet);
+
+/**
+ * Applies the stylesheet xslt to each of the given XML documents. Larger
+ * sets of documents are transformed in parallel by shared worker threads,
+ * so the documents must not be accessed until the function returns.
+ *
+ * @param docs		array of XML source documents
+ * @param paramSets	array of parameter sets (will be free'd, entries can be NULL)
+ * @param count		number of documents
+ * @param xsltName	name of a stylesheet
+ *
+ * @returns newly allocated array of count results (entries can be NULL)
+ */
+gchar ** render_xml_parallel (xmlDocPtr *docs, renderParamPtr *paramSets, guint count, const gchar *xsltName);
+
 /**
  * Creates a new rendering parameter set.
  *
@@ -55,6 +82,14 @@ renderParamPtr render_parameter_new (void);
  */
 void render_parameter_add (renderParamPtr paramSet, const gchar *fmt, ...);
 
+/**
+ * Frees the given parameter set. Only needed for parameter
+ * sets not passed to render_xml().
+ *
+ * @param paramSet	the parameter set
+ */
+void render_parameter_free (renderParamPtr paramSet);
+
 /**
  * Returns CSS definitions for inclusion in XHTML output.
  *
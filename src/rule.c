@@ -30,12 +30,19 @@
 #define ITEM_TITLE_MATCH_RULE_ID	"exact_title"
 #define ITEM_DESC_MATCH_RULE_ID		"exact_desc"
 #define FEED_TITLE_MATCH_RULE_ID	"feed_title"
+#define ITEM_CASEFOLD_MATCH_RULE_ID	"casefold"
+#define ITEM_WORD_MATCH_RULE_ID		"word"
+#define ITEM_REGEX_MATCH_RULE_ID	"regex"
 
 /** list of available search folder rules */
 static GSList *ruleFunctions = NULL;
 
 static void rule_init (void);
 
+static gboolean rule_check_item_casefold (rulePtr rule, itemPtr item);
+static gboolean rule_check_item_word (rulePtr rule, itemPtr item);
+static gboolean rule_check_item_regex (rulePtr rule, itemPtr item);
+
 GSList *
 rule_get_available_rules (void)
 {
@@ -61,7 +68,7 @@ rule_new (const gchar *ruleId,
 			rulePtr rule = (rulePtr) g_new0 (struct rule, 1);
 			rule->ruleInfo = ruleInfo;
 			rule->additive = additive;
-			rule->value = common_strreplace (g_strdup (value), "'", "");	
+			rule_set_value (rule, value);
 			return rule;
 		}
 		
@@ -70,10 +77,59 @@ rule_new (const gchar *ruleId,
 	return NULL;
 }
 
+/* Prepares the rule value once instead of on each check */
+static void
+rule_compile (rulePtr rule)
+{
+	ruleCheckFunc	func = rule->ruleInfo->checkFunc;
+	GError		*error = NULL;
+
+	g_free (rule->foldedValue);
+	rule->foldedValue = NULL;
+	if (rule->regex) {
+		g_regex_unref (rule->regex);
+		rule->regex = NULL;
+	}
+
+	if (!rule->value)
+		return;
+
+	if ((func == rule_check_item_casefold) || (func == rule_check_item_word))
+		rule->foldedValue = g_utf8_casefold (rule->value, -1);
+
+	if (func == rule_check_item_regex) {
+		rule->regex = g_regex_new (rule->value, G_REGEX_OPTIMIZE, 0, &error);
+		if (error) {
+			debug2 (DEBUG_CACHE, "invalid regular expression \"%s\": %s", rule->value, error->message);
+			g_error_free (error);
+		}
+	}
+}
+
+void
+rule_set_value (rulePtr rule, const gchar *value)
+{
+	g_free (rule->value);
+	rule->value = common_strreplace (g_strdup (value), "'", "");
+	rule_compile (rule);
+}
+
+gboolean
+rule_is_valid (rulePtr rule)
+{
+	if (rule->ruleInfo->checkFunc == rule_check_item_regex)
+		return (NULL != rule->regex);
+
+	return TRUE;
+}
+
 void 
 rule_free (rulePtr rule)
 {
 	g_free (rule->value);
+	g_free (rule->foldedValue);
+	if (rule->regex)
+		g_regex_unref (rule->regex);
 	g_free (rule);
 }
 
@@ -118,7 +174,13 @@ rule_check_item_has_enc (rulePtr rule, itemPtr item)
 static gboolean
 rule_check_item_category (rulePtr rule, itemPtr item)
 {
-	GSList	*iter = metadata_list_get_values (item->metadata, "category");
+	static guint	categoryKey = 0;
+	GSList		*iter;
+
+	if (!categoryKey)
+		categoryKey = metadata_type_get_key ("category");
+
+	iter = metadata_list_get_values_by_key (item->metadata, categoryKey);
 
 	while (iter) {
 		if (g_str_equal (rule->value, (gchar *)iter->data))
@@ -141,6 +203,60 @@ rule_check_feed_title (rulePtr rule, itemPtr item)
 	return (NULL != g_strstr_len (feedNode->title, -1, rule->value));
 }
 
+/* The following rules search the plain text of title and description
+   (without markup) which is created once per loaded item. */
+
+static gboolean
+rule_check_item_casefold (rulePtr rule, itemPtr item)
+{
+	if (!rule->foldedValue)
+		return FALSE;
+
+	return (NULL != strstr (item_get_folded_search_text (item), rule->foldedValue));
+}
+
+static gboolean
+rule_is_word_char (const gchar *p)
+{
+	gunichar c = g_utf8_get_char (p);
+
+	return g_unichar_isalnum (c) || ('_' == c);
+}
+
+static gboolean
+rule_check_item_word (rulePtr rule, itemPtr item)
+{
+	const gchar	*text = item_get_folded_search_text (item);
+	const gchar	*match = text;
+	gsize		length;
+
+	if (!rule->foldedValue)
+		return FALSE;
+
+	length = strlen (rule->foldedValue);
+	if (!length)
+		return TRUE;
+
+	while (NULL != (match = strstr (match, rule->foldedValue))) {
+		if (((match == text) || !rule_is_word_char (g_utf8_prev_char (match))) &&
+		    !rule_is_word_char (match + length))
+			return TRUE;
+
+		match = g_utf8_next_char (match);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+rule_check_item_regex (rulePtr rule, itemPtr item)
+{
+	if (!rule->regex)
+		return FALSE;
+
+	return g_regex_match (rule->regex, item_get_search_text (item), 0, NULL);
+}
+
 /* rule initialization */
 
 static void
@@ -149,7 +265,8 @@ rule_info_add (ruleCheckFunc checkFunc,
           gchar *title,
           gchar *positive,
           gchar *negative,
-          gboolean needsParameter)
+          gboolean needsParameter,
+          guint textFields)
 {
 	ruleInfoPtr	ruleInfo;
 
@@ -160,6 +277,7 @@ rule_info_add (ruleCheckFunc checkFunc,
 	ruleInfo->negative = negative;
 	ruleInfo->needsParameter = needsParameter;	
 	ruleInfo->checkFunc = checkFunc;
+	ruleInfo->textFields = textFields;
 	ruleFunctions = g_slist_append (ruleFunctions, ruleInfo);
 }
 
@@ -168,17 +286,20 @@ rule_init (void)
 {
 	debug_enter ("rule_init");
 
-	/*        SQL condition builder function	in-memory check function	feedlist.opml rule id           rule menu label         positive menu option    negative menu option    has param */ 
-	/*        ========================================================================================================================================================================================*/
+	/*        SQL condition builder function	in-memory check function	feedlist.opml rule id           rule menu label         positive menu option    negative menu option    has param	searched text fields */ 
+	/*        ====================================================================================================================================================================================================================*/
 	
-	rule_info_add (rule_check_item_all,		ITEM_MATCH_RULE_ID,		_("Item"),		_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_title,		ITEM_TITLE_MATCH_RULE_ID,	_("Item title"),	_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_description,	ITEM_DESC_MATCH_RULE_ID,	_("Item body"),		_("does contain"),	_("does not contain"),	TRUE);
-	rule_info_add (rule_check_item_is_unread,	"unread",			_("Read status"),	_("is unread"),		_("is read"),		FALSE);
-	rule_info_add (rule_check_item_is_flagged,	"flagged",			_("Flag status"),	_("is flagged"),	_("is unflagged"),	FALSE);
-	rule_info_add (rule_check_item_has_enc,		"enclosure",			_("Podcast"),		_("included"),		_("not included"),	FALSE);
-	rule_info_add (rule_check_item_category,	"category",			_("Category"),		_("is set"),		_("is not set"),	TRUE);
-	rule_info_add (rule_check_feed_title,		FEED_TITLE_MATCH_RULE_ID,	_("Feed title"),	_("does contain"),	_("does not contain"),	TRUE);
+	rule_info_add (rule_check_item_all,		ITEM_MATCH_RULE_ID,		_("Item"),		_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_TITLE | RULE_TEXT_DESCRIPTION);
+	rule_info_add (rule_check_item_title,		ITEM_TITLE_MATCH_RULE_ID,	_("Item title"),	_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_TITLE);
+	rule_info_add (rule_check_item_description,	ITEM_DESC_MATCH_RULE_ID,	_("Item body"),		_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_DESCRIPTION);
+	rule_info_add (rule_check_item_is_unread,	"unread",			_("Read status"),	_("is unread"),		_("is read"),		FALSE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_is_flagged,	"flagged",			_("Flag status"),	_("is flagged"),	_("is unflagged"),	FALSE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_has_enc,		"enclosure",			_("Podcast"),		_("included"),		_("not included"),	FALSE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_category,	"category",			_("Category"),		_("is set"),		_("is not set"),	TRUE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_feed_title,		FEED_TITLE_MATCH_RULE_ID,	_("Feed title"),	_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_casefold,	ITEM_CASEFOLD_MATCH_RULE_ID,	_("Item (ignoring case)"),	_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_word,		ITEM_WORD_MATCH_RULE_ID,	_("Item (whole word)"),	_("does contain"),	_("does not contain"),	TRUE,		RULE_TEXT_NONE);
+	rule_info_add (rule_check_item_regex,		ITEM_REGEX_MATCH_RULE_ID,	_("Item (regular expression)"),	_("does match"),	_("does not match"),	TRUE,		RULE_TEXT_NONE);
 
 	debug_exit ("rule_init");
 }
@@ -25,6 +25,13 @@
 
 #include "item.h"
 
+/** item fields searched by plain substring rules */
+typedef enum {
+	RULE_TEXT_NONE		= 0,		/**< no plain substring rule */
+	RULE_TEXT_TITLE		= (1<<0),	/**< item title is searched */
+	RULE_TEXT_DESCRIPTION	= (1<<1)	/**< item description is searched */
+} ruleTextFields;
+
 /** rule info structure */
 typedef struct ruleInfo {
 	const gchar	*ruleId;	/**< rule id for cache file storage */
@@ -34,6 +41,7 @@ typedef struct ruleInfo {
 	gboolean	needsParameter;	/**< some rules may require no parameter... */
 	
 	gpointer	checkFunc;	/**< the item check function */
+	guint		textFields;	/**< fields searched by a plain substring rule (see ruleTextFields) */
 } *ruleInfoPtr;
 
 /** structure to store a rule instance */
@@ -41,6 +49,9 @@ typedef struct rule {
 	gchar		*value;		/* the value of the rule, e.g. a search text */
 	ruleInfoPtr	ruleInfo;	/* info structure about rule check function */
 	gboolean	additive;	/* is the rule positive logic */
+
+	gchar		*foldedValue;	/* case folded value for case insensitive rules (or NULL) */
+	GRegex		*regex;		/* compiled value for regular expression rules (or NULL) */
 } *rulePtr;
 
 /** function type used to check items */
@@ -66,6 +77,25 @@ GSList * rule_get_available_rules (void);
  */
 rulePtr rule_new (const gchar *ruleId, const gchar *value, gboolean additive);
 
+/**
+ * Changes the value of the given rule and prepares
+ * the rule for matching the new value.
+ *
+ * @param rule		the rule
+ * @param value		the new value
+ */
+void rule_set_value (rulePtr rule, const gchar *value);
+
+/**
+ * Checks if the value of the given rule can be used
+ * for matching (e.g. is a valid regular expression).
+ *
+ * @param rule		the rule
+ *
+ * @returns TRUE if the rule value is valid
+ */
+gboolean rule_is_valid (rulePtr rule);
+
 /** 
  * Free's the given rule structure 
  *
@@ -31,6 +31,7 @@
 #include "feedlist.h"
 #include "metadata.h"
 #include "net.h"
+#include "xml.h"
 #include "ui/auth_dialog.h"
 #include "ui/itemview.h"
 #include "ui/liferea_shell.h"
@@ -542,35 +543,50 @@ subscription_export (subscriptionPtr subscription, xmlNodePtr xml, gboolean trus
 	g_free (interval);
 }
 
-void
-subscription_to_xml (subscriptionPtr subscription, xmlNodePtr xml)
+static void
+subscription_serialize (subscriptionPtr subscription, xmlNodePtr xml, GString *key)
 {
 	gchar	*tmp;
 	
-	xmlNewTextChild (xml, NULL, "feedSource", subscription_get_source (subscription));
-	xmlNewTextChild (xml, NULL, "feedOrigSource", subscription_get_orig_source (subscription));
+	xml_add_text_child (xml, key, "feedSource", subscription_get_source (subscription));
+	xml_add_text_child (xml, key, "feedOrigSource", subscription_get_orig_source (subscription));
 
 	tmp = g_strdup_printf ("%d", subscription_get_default_update_interval (subscription));
-	xmlNewTextChild (xml, NULL, "feedUpdateInterval", tmp);
+	xml_add_text_child (xml, key, "feedUpdateInterval", tmp);
 	g_free (tmp);
 
 	tmp = g_strdup_printf ("%d", subscription->discontinued?1:0);
-	xmlNewTextChild (xml, NULL, "feedDiscontinued", tmp);
+	xml_add_text_child (xml, key, "feedDiscontinued", tmp);
 	g_free (tmp);
 
 	if (subscription->updateError)
-		xmlNewTextChild (xml, NULL, "updateError", subscription->updateError);
+		xml_add_text_child (xml, key, "updateError", subscription->updateError);
 	if (subscription->httpError) {
-		xmlNewTextChild (xml, NULL, "httpError", subscription->httpError);
+		xml_add_text_child (xml, key, "httpError", subscription->httpError);
 
 		tmp = g_strdup_printf ("%d", subscription->httpErrorCode);
-		xmlNewTextChild (xml, NULL, "httpErrorCode", tmp);
+		xml_add_text_child (xml, key, "httpErrorCode", tmp);
 		g_free (tmp);
 	}
 	if (subscription->filterError)
-		xmlNewTextChild (xml, NULL, "filterError", subscription->filterError);
+		xml_add_text_child (xml, key, "filterError", subscription->filterError);
 
-	metadata_add_xml_nodes (subscription->metadata, xml);
+	if (key)
+		metadata_list_to_render_key (subscription->metadata, key);
+	else
+		metadata_add_xml_nodes (subscription->metadata, xml);
+}
+
+void
+subscription_to_xml (subscriptionPtr subscription, xmlNodePtr xml)
+{
+	subscription_serialize (subscription, xml, NULL);
+}
+
+void
+subscription_to_render_key (subscriptionPtr subscription, GString *key)
+{
+	subscription_serialize (subscription, NULL, key);
 }
 
 void
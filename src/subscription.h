@@ -37,6 +37,7 @@ enum cache_limit {
 enum feed_request_flags {
 	FEED_REQ_RESET_TITLE		= (1<<0),	/**< Feed's title should be reset to default upon update */
 	FEED_REQ_PRIORITY_HIGH		= (1<<3),	/**< set to signal that this is an important user triggered request */
+	FEED_REQ_PRIORITY_LOW		= (1<<4),	/**< set for background downloads to be done when nothing else is to be done */
 };
  
 /** Common structure to hold all information about a single subscription. */
@@ -52,7 +53,7 @@ typedef struct subscription {
 	gint		updateInterval;		/**< user defined update interval in minutes */	
 	guint		defaultInterval;	/**< optional update interval as specified by the feed in minutes */
 	
-	GSList		*metadata;		/**< metadata list assigned to this subscription */
+	struct metadataList *metadata;		/**< metadata list assigned to this subscription */
 	
 	gchar		*updateError;		/**< textual description of processing errors */
 	gchar		*httpError;		/**< textual description of HTTP protocol errors */
@@ -105,6 +106,15 @@ void subscription_export (subscriptionPtr subscription, xmlNodePtr xml, gboolean
  */
 void subscription_to_xml (subscriptionPtr subscription, xmlNodePtr xml);
 
+/**
+ * Appends everything subscription_to_xml() would serialize
+ * to the given render cache key.
+ *
+ * @param subscription	the subscription
+ * @param key		the key to append to
+ */
+void subscription_to_render_key (subscriptionPtr subscription, GString *key);
+
 /**
  * Triggers updating a subscription. Will download the 
  * the document indicated by the source URL of the subscription.
@@ -56,6 +56,26 @@ feed_list_view_row_changed_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIt
 		ui_node_update_iter(node->id, iter);
 }
 
+/* Loads deferred favicons only when their row is rendered, so
+   favicons of collapsed folders are not loaded during startup */
+static void
+feed_list_view_icon_cell_data (GtkTreeViewColumn *column, GtkCellRenderer *cell, GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+	GdkPixbuf	*icon;
+	nodePtr		node;
+
+	gtk_tree_model_get (model, iter, FS_ICON, &icon, FS_PTR, &node, -1);
+	if (!icon && node) {
+		icon = node_get_icon (node);
+		if (icon)
+			g_object_ref (icon);
+	}
+
+	g_object_set (cell, "pixbuf", icon, NULL);
+	if (icon)
+		g_object_unref (icon);
+}
+
 static void
 feed_list_view_selection_changed_cb (GtkTreeSelection *selection, gpointer data)
 {
@@ -252,7 +272,7 @@ feed_list_view_init (GtkTreeView *treeview)
 	gtk_tree_view_column_pack_start (column, iconRenderer, FALSE);
 	gtk_tree_view_column_pack_start (column, textRenderer, TRUE);
 	
-	gtk_tree_view_column_add_attribute (column, iconRenderer, "pixbuf", FS_ICON);
+	gtk_tree_view_column_set_cell_data_func (column, iconRenderer, feed_list_view_icon_cell_data, NULL, NULL);
 	gtk_tree_view_column_add_attribute (column, textRenderer, "markup", FS_LABEL);
 	
 	gtk_tree_view_column_set_resizable (column, TRUE);
@@ -726,7 +726,7 @@ item_list_view_add_item_to_tree_store (ItemListView *ilv, GtkTreeStore *itemstor
 		                       IS_TIME, (guint64)item->time,
 		                       IS_NR, item->id,
 				       IS_PARENT, node,
-		                       IS_FAVICON, node->icon,
+		                       IS_FAVICON, node_get_favicon (node),
 		                       IS_ENCICON, item->hasEnclosure?icon_get (ICON_ENCLOSURE):NULL,
 				       IS_ENCLOSURE, item->hasEnclosure,
 				       IS_SOURCE, node,
@@ -944,6 +944,45 @@ item_list_view_find_unread_item (ItemListView *ilv, gulong startId)
 	return NULL;
 }
 
+gulong
+item_list_view_get_next_item_id (ItemListView *ilv, gulong id)
+{
+	GtkTreeIter	iter;
+
+	if (!item_list_view_id_to_iter (ilv, id, &iter))
+		return 0;
+
+	if (!gtk_tree_model_iter_next (gtk_tree_view_get_model (ilv->priv->treeview), &iter))
+		return 0;
+
+	return item_list_view_iter_to_id (ilv, &iter);
+}
+
+gulong
+item_list_view_find_unread_id (ItemListView *ilv, gulong startId)
+{
+	GtkTreeIter	iter;
+	GtkTreeModel	*model;
+	gboolean	valid;
+	gint		weight;
+
+	model = gtk_tree_view_get_model (ilv->priv->treeview);
+
+	if (startId)
+		valid = item_list_view_id_to_iter (ilv, startId, &iter);
+	else
+		valid = gtk_tree_model_get_iter_first (model, &iter);
+
+	while (valid) {
+		gtk_tree_model_get (model, &iter, ITEMSTORE_UNREAD, &weight, -1);
+		if (PANGO_WEIGHT_BOLD == weight)
+			return item_list_view_iter_to_id (ilv, &iter);
+		valid = gtk_tree_model_iter_next (model, &iter);
+	}
+
+	return 0;
+}
+
 void
 on_next_unread_item_activate (GtkMenuItem *menuitem, gpointer user_data)
 {
@@ -213,6 +213,28 @@ void on_popup_remove_selected (void);
  */
 itemPtr item_list_view_find_unread_item (ItemListView *ilv, gulong startId);
 
+/**
+ * Returns the id of the item following the given item in a
+ * ItemListView according to the current GtkTreeView sorting order.
+ *
+ * @param ilv		the ItemListView
+ * @param id		the item id
+ *
+ * @returns item id (or 0)
+ */
+gulong item_list_view_get_next_item_id (ItemListView *ilv, gulong id);
+
+/**
+ * Finds the next item starting at the given item that the
+ * ItemListView shows as unread, without loading any items.
+ *
+ * @param ilv		the ItemListView
+ * @param startId	0 or the item id to start from
+ *
+ * @returns item id (or 0)
+ */
+gulong item_list_view_find_unread_id (ItemListView *ilv, gulong startId);
+
 /**
  * Searches the displayed feed and then all feeds for an unread
  * item. If one it found, it is displayed.
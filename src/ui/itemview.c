@@ -53,6 +53,7 @@ struct ItemViewPrivate {
 	gboolean	needsHTMLViewUpdate;	/**< flag to be set when HTML rendering is to be 
 						     updated, used to delay HTML updates */
 	gboolean	hasEnclosures;		/**< TRUE if at least one item of the current itemset has an enclosure */
+	guint		prefetchSource;		/**< idle source id of item prefetching (or 0) */
 						     
 	nodeViewType	viewMode;		/**< current viewing mode */
 	guint		currentLayoutMode;	/**< layout mode (3 pane, 2 pane, wide view) */
@@ -76,6 +77,9 @@ itemview_finalize (GObject *object)
 {
 	ItemViewPrivate *priv = ITEMVIEW_GET_PRIVATE (object);
 
+	if (priv->prefetchSource)
+		g_source_remove (priv->prefetchSource);
+
 	if (priv->htmlview) {
 		/* save zoom preferences */
 		conf_set_int_value (LAST_ZOOMLEVEL, (gint)(100.* liferea_htmlview_get_zoom (priv->htmlview)));
@@ -310,6 +314,56 @@ itemview_find_unread_item (gulong startId)
 	return result;
 }
 
+static gboolean
+itemview_prefetch_items_cb (gpointer user_data)
+{
+	ItemViewPrivate	*ivp = itemview->priv;
+	gulong		selectedId, nextId, unreadId;
+	itemPtr		item;
+
+	ivp->prefetchSource = 0;
+
+	if (ITEMVIEW_SINGLE_ITEM != ivp->mode || ivp->browsing)
+		return FALSE;
+
+	selectedId = itemlist_get_selected_id ();
+	if (!selectedId)
+		return FALSE;
+
+	debug_start_measurement (DEBUG_HTML);
+
+	/* what the cursor down key would select... */
+	nextId = item_list_view_get_next_item_id (ivp->itemListView, selectedId);
+	if (nextId && (item = item_load (nextId))) {
+		htmlview_prefetch_item (item);
+		item_unload (item);
+	}
+
+	/* ...and what "Next Unread Item" would select (according to the
+	   item list, loading items to check their state would be too slow) */
+	unreadId = nextId?item_list_view_find_unread_id (ivp->itemListView, nextId):0;
+	if (!unreadId)
+		unreadId = item_list_view_find_unread_id (ivp->itemListView, 0);
+	if (unreadId && (unreadId != selectedId) && (unreadId != nextId) && (item = item_load (unreadId))) {
+		htmlview_prefetch_item (item);
+		item_unload (item);
+	}
+
+	debug_end_measurement (DEBUG_HTML, "item prefetching");
+
+	return FALSE;
+}
+
+void
+itemview_prefetch_items (void)
+{
+	ItemViewPrivate	*ivp = itemview->priv;
+
+	/* let the HTML view display the selected item first */
+	if (!ivp->prefetchSource)
+		ivp->prefetchSource = g_idle_add_full (G_PRIORITY_LOW, itemview_prefetch_items_cb, NULL, NULL);
+}
+
 void
 itemview_scroll (void)
 {
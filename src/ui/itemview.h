@@ -197,6 +197,15 @@ void itemview_display_info (const gchar *html);
  */
 itemPtr itemview_find_unread_item (gulong startId);
 
+/**
+ * itemview_prefetch_items:
+ *
+ * Schedules rendering the items most likely to be selected after
+ * the currently selected item (the next unread item and the next
+ * item in the list) in the background.
+ */
+void itemview_prefetch_items (void);
+
 /**
  * itemview_scroll:
  *
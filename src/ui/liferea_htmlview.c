@@ -34,6 +34,7 @@
 #include "enclosure.h"
 #include "feed.h"
 #include "feedlist.h"
+#include "image_cache.h"
 #include "net.h"
 #include "net_monitor.h"
 #include "social.h"
@@ -69,6 +70,7 @@ struct LifereaHtmlViewPrivate {
 
 	gboolean	internal;		/**< TRUE if internal view presenting generated HTML with special links */
 	gboolean	forceInternalBrowsing;	/**< TRUE if clicked links should be force loaded within this view (regardless of global preference) */
+	guint		documentId;		/**< changes with each written or launched document */
 	
 	htmlviewImplPtr impl;			/**< Browser widget support implementation */
 };
@@ -303,6 +305,7 @@ liferea_htmlview_write (LifereaHtmlView *htmlview, const gchar *string, const gc
 	const gchar	*baseURL = base;
 	
 	htmlview->priv->internal = TRUE;	/* enables special links */
+	htmlview->priv->documentId++;
 	
 	if (baseURL == NULL)
 		baseURL = "file:///";
@@ -324,6 +327,64 @@ liferea_htmlview_write (LifereaHtmlView *htmlview, const gchar *string, const gc
 	gtk_widget_hide (htmlview->priv->toolbar);
 }
 
+guint
+liferea_htmlview_get_document_id (LifereaHtmlView *htmlview)
+{
+	return htmlview->priv->documentId;
+}
+
+gboolean
+liferea_htmlview_execute_script (LifereaHtmlView *htmlview, guint documentId, const gchar *script)
+{
+	/* Never modify external content */
+	if (!htmlview->priv->internal || (documentId != htmlview->priv->documentId))
+		return FALSE;
+
+	if (!RENDERER (htmlview)->executeScript)
+		return FALSE;
+
+	return (RENDERER (htmlview)->executeScript) (htmlview->priv->renderWidget, script);
+}
+
+gboolean
+liferea_htmlview_scripts_enabled (LifereaHtmlView *htmlview)
+{
+	if (!RENDERER (htmlview)->executeScript || !RENDERER (htmlview)->scriptsEnabled)
+		return FALSE;
+
+	return (RENDERER (htmlview)->scriptsEnabled) (htmlview->priv->renderWidget);
+}
+
+void
+liferea_htmlview_on_script_message (LifereaHtmlView *htmlview, const gchar *message)
+{
+	/* Only internal documents can request items */
+	if (!htmlview->priv->internal)
+		return;
+
+	if (g_str_has_prefix (message, "liferea-load-items:"))
+		htmlview_load_items (htmlview, message + strlen ("liferea-load-items:"));
+}
+
+gchar *
+liferea_htmlview_get_local_resource (LifereaHtmlView *htmlview, const gchar *url)
+{
+	gchar	*filename, *uri;
+
+	/* Do not change what external content loads */
+	if (!htmlview->priv->internal)
+		return NULL;
+
+	filename = image_cache_get_file (url);
+	if (!filename)
+		return NULL;
+
+	uri = g_filename_to_uri (filename, NULL, NULL);
+	g_free (filename);
+
+	return uri;
+}
+
 void
 liferea_htmlview_clear (LifereaHtmlView *htmlview)
 {
@@ -461,6 +522,7 @@ liferea_htmlview_launch_URL_internal (LifereaHtmlView *htmlview, const gchar *ur
 {
 	/* before loading untrusted URLs suppress internal link schema */
 	htmlview->priv->internal = FALSE;
+	htmlview->priv->documentId++;
 
 	browser_history_add_location (htmlview->priv->history, (gchar *)url);
 
@@ -86,6 +86,58 @@ void	liferea_htmlview_clear (LifereaHtmlView *htmlview);
  */
 void	liferea_htmlview_write (LifereaHtmlView *htmlview, const gchar *string, const gchar *base);
 
+/**
+ * Returns an id identifying the currently displayed document. The id
+ * changes whenever another document is written or loaded.
+ *
+ * @param htmlview	the HTML view
+ *
+ * @returns document id
+ */
+guint	liferea_htmlview_get_document_id (LifereaHtmlView *htmlview);
+
+/**
+ * Runs the given JavaScript code to modify a document written using
+ * liferea_htmlview_write(). Fails if the document is not displayed
+ * anymore, not yet completely loaded or if scripts cannot be run.
+ *
+ * @param htmlview	the HTML view
+ * @param documentId	id of the document to modify
+ * @param script	JavaScript code
+ *
+ * @returns TRUE if the script was run
+ */
+gboolean liferea_htmlview_execute_script (LifereaHtmlView *htmlview, guint documentId, const gchar *script);
+
+/**
+ * Checks wether documents written to the HTML view can run scripts.
+ *
+ * @param htmlview	the HTML view
+ *
+ * @returns TRUE if scripts are enabled
+ */
+gboolean liferea_htmlview_scripts_enabled (LifereaHtmlView *htmlview);
+
+/**
+ * Callback for plugins to process messages of scripts in internal
+ * documents (e.g. requests of not yet rendered items).
+ *
+ * @param htmlview	the HTML view
+ * @param message	the message
+ */
+void	liferea_htmlview_on_script_message (LifereaHtmlView *htmlview, const gchar *message);
+
+/**
+ * Callback for plugins to map resources of internal documents
+ * to local copies (e.g. from the image cache).
+ *
+ * @param htmlview	the HTML view
+ * @param url		the resource URL
+ *
+ * @returns URL of a local copy (to be free'd using g_free) or NULL
+ */
+gchar *	liferea_htmlview_get_local_resource (LifereaHtmlView *htmlview, const gchar *url);
+
 /**
  * Callback for plugins to process on-url events. Depending on 
  * the link type the link will be copied to the status bar.
@@ -184,6 +236,8 @@ typedef struct htmlviewImpl {
 	void 		(*init)			(void);
 	GtkWidget*	(*create)		(LifereaHtmlView *htmlview);
 	void		(*write)		(GtkWidget *widget, const gchar *string, guint length, const gchar *base, const gchar *contentType);
+	gboolean	(*executeScript)	(GtkWidget *widget, const gchar *script);
+	gboolean	(*scriptsEnabled)	(GtkWidget *widget);
 	void		(*launch)		(GtkWidget *widget, const gchar *url);
 	gfloat		(*zoomLevelGet)		(GtkWidget *widget);
 	void		(*zoomLevelSet)		(GtkWidget *widget, gfloat zoom);
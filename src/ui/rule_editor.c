@@ -22,6 +22,7 @@
 #include "ui/rule_editor.h"
 #include "ui/ui_common.h"
 
+#include "common.h"
 #include "rule.h"
 
 /*
@@ -91,14 +92,29 @@ rule_editor_destroy_param_widget (GtkWidget *widget, gpointer data)
 	gtk_widget_destroy(widget);
 }
 
+/* marks rule values that cannot be used (e.g. invalid regular expressions) */
+static void
+rule_editor_update_value_state (GtkEntry *entry, rulePtr rule)
+{
+	if (rule_is_valid (rule)) {
+		gtk_entry_set_icon_from_stock (entry, GTK_ENTRY_ICON_SECONDARY, NULL);
+	} else {
+		gtk_entry_set_icon_from_stock (entry, GTK_ENTRY_ICON_SECONDARY, GTK_STOCK_DIALOG_WARNING);
+		gtk_entry_set_icon_tooltip_text (entry, GTK_ENTRY_ICON_SECONDARY, _("This is not a valid regular expression. The rule will never match."));
+	}
+}
+
 static void
 on_rulevalue_changed (GtkEditable *editable, gpointer user_data)
 {
 	rulePtr	rule = (rulePtr)user_data;
+	gchar	*value;
 	
-	if (rule->value)
-		g_free (rule->value);
-	rule->value = g_strdup (gtk_editable_get_chars (editable,0,-1));
+	value = gtk_editable_get_chars (editable, 0, -1);
+	rule_set_value (rule, value);
+	g_free (value);
+
+	rule_editor_update_value_state (GTK_ENTRY (editable), rule);
 }
 
 /* callback for rule additive option menu */
@@ -140,6 +156,7 @@ rule_editor_setup_widgets (struct changeRequest *changeRequest, rulePtr rule)
 	if (ruleInfo->needsParameter) {
 		widget = gtk_entry_new ();
 		gtk_entry_set_text (GTK_ENTRY (widget), rule->value);
+		rule_editor_update_value_state (GTK_ENTRY (widget), rule);
 		gtk_widget_show (widget);
 		g_signal_connect (G_OBJECT (widget), "changed", G_CALLBACK(on_rulevalue_changed), rule);
 		gtk_box_pack_start (GTK_BOX (changeRequest->paramHBox), widget, FALSE, FALSE, 0);
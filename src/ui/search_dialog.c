@@ -135,6 +135,7 @@ on_search_dialog_response (GtkDialog *dialog, gint responseId, gpointer user_dat
 	if (2 == responseId) { /* + Search Folder */
 		rule_editor_save (sd->priv->re, vfolder->itemset);
 		vfolder->itemset->anyMatch = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (liferea_dialog_lookup (sd->priv->dialog, "anyRuleRadioBtn2")));
+		vfolder_rules_changed ();
 		
 		nodePtr node = vfolder->node;
 		sd->priv->vfolder = NULL;
@@ -180,7 +180,7 @@ add_node_indicator (nodePtr node)
 	g_signal_connect (indicator, "user-display", G_CALLBACK (on_indicator_clicked), node);
 
 	/* load favicon */
-	pixbuf = gdk_pixbuf_new_from_file (node->iconFile, NULL);
+	pixbuf = gdk_pixbuf_new_from_file (node_get_favicon_file (node), NULL);
 
 	/* display favicon */
 	indicate_gtk_indicator_set_property_icon (indicator, "icon", pixbuf);
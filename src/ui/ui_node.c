@@ -284,6 +284,7 @@ ui_node_update (const gchar *nodeId)
 	gchar		*label;
 	guint		labeltype;
 	nodePtr		node;
+	gpointer	icon = NULL;
 
 	node = node_from_id (nodeId);
 	iter = ui_node_to_iter (nodeId);
@@ -322,9 +323,16 @@ ui_node_update (const gchar *nodeId)
 		}
 	}
 
+	/* Deferred favicons are stored as NULL and loaded when
+	   the row is rendered (see feed_list_view_icon_cell_data()) */
+	if (!node->available)
+		icon = icon_get (ICON_UNAVAILABLE);
+	else if (!node->iconDeferred)
+		icon = node_get_icon (node);
+
 	gtk_tree_store_set (feedstore, iter, FS_LABEL, label,
 	                                     FS_UNREAD, node->unreadCount,
-	                                     FS_ICON, node->available?node_get_icon (node):icon_get (ICON_UNAVAILABLE),
+	                                     FS_ICON, icon,
 	                                     -1);
 	g_free (label);
 
@@ -48,8 +48,10 @@ static GSList	*jobs = NULL;
 
 static GAsyncQueue *pendingHighPrioJobs = NULL;
 static GAsyncQueue *pendingJobs = NULL;
+static GAsyncQueue *pendingLowPrioJobs = NULL;
 static guint numberOfActiveJobs = 0;
 #define MAX_ACTIVE_JOBS	5
+#define MAX_ACTIVE_LOW_PRIO_JOBS	2	/**< keeps some slots free for other requests */
 
 /* update state interface */
 
@@ -482,6 +484,9 @@ update_dequeue_job (gpointer user_data)
 	if (!job)
 		job = (updateJobPtr)g_async_queue_try_pop(pendingJobs);
 
+	if (!job && (numberOfActiveJobs < MAX_ACTIVE_LOW_PRIO_JOBS))
+		job = (updateJobPtr)g_async_queue_try_pop(pendingLowPrioJobs);
+
 	if(!job)
 		return FALSE;	/* no request at the moment */
 
@@ -516,6 +521,8 @@ update_execute_request (gpointer owner,
 
 	if (flags & FEED_REQ_PRIORITY_HIGH) {
 		g_async_queue_push (pendingHighPrioJobs, (gpointer)job);
+	} else if (flags & FEED_REQ_PRIORITY_LOW) {
+		g_async_queue_push (pendingLowPrioJobs, (gpointer)job);
 	} else {
 		g_async_queue_push (pendingJobs, (gpointer)job);
 	}
@@ -579,6 +586,7 @@ update_init (void)
 {
 	pendingJobs = g_async_queue_new ();
 	pendingHighPrioJobs = g_async_queue_new ();
+	pendingLowPrioJobs = g_async_queue_new ();
 }
 
 void
@@ -595,6 +603,7 @@ update_deinit (void)
 
 	g_async_queue_unref (pendingJobs);
 	g_async_queue_unref (pendingHighPrioJobs);
+	g_async_queue_unref (pendingLowPrioJobs);
 	
 	g_slist_free (jobs);
 	jobs = NULL;
@@ -29,12 +29,23 @@
 #include "node.h"
 #include "rule.h"
 #include "vfolder_loader.h"
+#include "vfolder_matcher.h"
 #include "ui/icons.h"
 #include "ui/search_folder_dialog.h"
 
 /** The list of all existing vfolders. Used for updating vfolder information upon item changes */
 static GSList		*vfolders = NULL;
 
+/** Rules of all vfolders compiled for item updates, built on demand */
+static vfolderMatcherPtr	matcher = NULL;
+
+void
+vfolder_rules_changed (void)
+{
+	vfolder_matcher_free (matcher);
+	matcher = NULL;
+}
+
 vfolderPtr
 vfolder_new (nodePtr node) 
 {
@@ -49,6 +60,7 @@ vfolder_new (nodePtr node)
 	vfolder->itemset->anyMatch = TRUE;
 	vfolder->node = node;
 	vfolders = g_slist_append (vfolders, vfolder);
+	vfolder_rules_changed ();
 
 	if (!node->title)
 		node_set_title (node, _("New Search Folder"));	/* set default title */
@@ -129,33 +141,90 @@ vfolder_foreach (nodeActionFunc func)
 GSList *
 vfolder_get_all_with_item_id (itemPtr item)
 {
-	GSList	*result = NULL;
-	GSList	*iter = vfolders;
-	
-	while (iter) {
+	if (!matcher)
+		matcher = vfolder_matcher_new (vfolders);
+
+	return vfolder_matcher_match (matcher, item);
+}
+
+void
+vfolder_item_counts_changed (const gchar *id, gint itemCountDelta, gint unreadCountDelta)
+{
+	GSList	*iter;
+
+	for (iter = vfolders; iter; iter = g_slist_next (iter)) {
 		vfolderPtr vfolder = (vfolderPtr)iter->data;
-		if (itemset_check_item (vfolder->itemset, item))
-			result = g_slist_append (result, vfolder);
-		iter = g_slist_next (iter);
+
+		if (vfolder->node && vfolder->node->id && g_str_equal (vfolder->node->id, id)) {
+			vfolder->itemCountDelta += itemCountDelta;
+			vfolder->unreadCountDelta += unreadCountDelta;
+			node_schedule_update_counters (vfolder->node);
+			return;
+		}
 	}
+}
+
+void
+vfolder_recount (nodePtr node)
+{
+	vfolderPtr	vfolder = (vfolderPtr)node->data;
 
-	return result;
+	vfolder->countersValid = FALSE;
+	node_schedule_update_counters (node);
 }
 
-GSList *
-vfolder_get_all_without_item_id (itemPtr item)
+void
+vfolder_update_read_items (GHashTable *items)
 {
-	GSList	*result = NULL;
-	GSList	*iter = vfolders;
-	
-	while (iter) {
+	GSList		*iter, *loaded = NULL, *iter2;
+	itemArenaPtr	arena = NULL;
+	GHashTableIter	hiter;
+	gpointer	id;
+
+	for (iter = vfolders; iter; iter = g_slist_next (iter)) {
 		vfolderPtr vfolder = (vfolderPtr)iter->data;
-		if (!itemset_check_item (vfolder->itemset, item))
-			result = g_slist_append (result, vfolder);
-		iter = g_slist_next (iter);
+		GHashTable *matching, *notMatching;
+
+		switch (itemset_check_read_items (vfolder->itemset)) {
+			case ITEMSET_READ_ITEMS_MATCH:
+				db_search_folder_add_item_ids (vfolder->node->id, items);
+				break;
+			case ITEMSET_READ_ITEMS_DONT_MATCH:
+				db_search_folder_remove_item_ids (vfolder->node->id, items);
+				break;
+			case ITEMSET_READ_ITEMS_UNKNOWN:
+				/* load the items once for all search folders */
+				if (!arena) {
+					arena = item_arena_new ();
+					g_hash_table_iter_init (&hiter, items);
+					while (g_hash_table_iter_next (&hiter, &id, NULL)) {
+						itemPtr item = item_arena_load (arena, GPOINTER_TO_UINT (id));
+						if (item)
+							loaded = g_slist_prepend (loaded, item);
+					}
+				}
+
+				matching = g_hash_table_new (g_direct_hash, g_direct_equal);
+				notMatching = g_hash_table_new (g_direct_hash, g_direct_equal);
+				for (iter2 = loaded; iter2; iter2 = g_slist_next (iter2)) {
+					itemPtr item = (itemPtr)iter2->data;
+					if (itemset_check_item (vfolder->itemset, item))
+						g_hash_table_insert (matching, GUINT_TO_POINTER (item->id), (gpointer)item->nodeId);
+					else
+						g_hash_table_insert (notMatching, GUINT_TO_POINTER (item->id), NULL);
+				}
+				db_search_folder_add_item_ids (vfolder->node->id, matching);
+				db_search_folder_remove_item_ids (vfolder->node->id, notMatching);
+				g_hash_table_destroy (matching);
+				g_hash_table_destroy (notMatching);
+				break;
+			default:
+				break;
+		}
 	}
 
-	return result;
+	g_slist_free (loaded);
+	item_arena_free (arena);
 }
 
 static void
@@ -176,6 +245,7 @@ vfolder_import (nodePtr node,
 	vfolder->itemset = g_new0 (struct itemSet, 1);
 	
 	vfolder_import_rules (cur, vfolder);
+	vfolder_rules_changed ();
 }
 
 static void
@@ -222,7 +292,9 @@ vfolder_reset (vfolderPtr vfolder)
 
 	g_list_free (vfolder->itemset->ids);
 	vfolder->itemset->ids = NULL;
+	vfolder->countersValid = FALSE;
 	db_search_folder_reset (vfolder->node->id);
+	vfolder_rules_changed ();
 }
 
 void
@@ -242,6 +314,7 @@ vfolder_free (nodePtr node)
 	debug_enter ("vfolder_free");
 	
 	vfolders = g_slist_remove (vfolders, vfolder);
+	vfolder_rules_changed ();
 	itemset_free (vfolder->itemset);
 		
 	debug_exit ("vfolder_free");
@@ -254,12 +327,22 @@ static void vfolder_save (nodePtr node) { }
 static void
 vfolder_update_counters (nodePtr node) 
 {
-	/* There is no unread handling for search folders
-	   for performance reasons. So set everything to 0 
-	   here and don't bother with GUI updates... */
+	vfolderPtr	vfolder = (vfolderPtr)node->data;
+
+	/* Search folders are counted once using a join on the read
+	   state of their items. Afterwards single item updates only
+	   pass counter deltas, so toggling the read state of an item
+	   does not cause counting all items of each search folder. */
+	if (vfolder->countersValid && !vfolder->reloading) {
+		node->itemCount = MAX (0, (gint)node->itemCount + vfolder->itemCountDelta);
+		node->unreadCount = MAX (0, (gint)node->unreadCount + vfolder->unreadCountDelta);
+	} else {
+		db_search_folder_get_counts (node->id, &node->itemCount, &node->unreadCount);
+		vfolder->countersValid = !vfolder->reloading;
+	}
+	vfolder->itemCountDelta = 0;
+	vfolder->unreadCountDelta = 0;
 	node->needsUpdate = TRUE;
-	node->unreadCount = 0;
-	node->itemCount = db_search_folder_get_item_count (node->id);
 }
 
 static void
@@ -291,6 +374,7 @@ vfolder_get_node_type (void)
 { 
 	static struct nodeType nti = {
 		NODE_CAPABILITY_SHOW_ITEM_FAVICONS |
+		NODE_CAPABILITY_SHOW_UNREAD_COUNT |
 		NODE_CAPABILITY_SHOW_ITEM_COUNT,
 		"vfolder",
 		NULL,
@@ -43,6 +43,10 @@ typedef struct vfolder {
 
 	gboolean	reloading;	/**< if the search folder is in async reloading */
 	gulong		loadOffset;	/**< when in reloading: current offset */
+
+	gboolean	countersValid;	/**< if the node counters were counted and are kept up to date with the deltas below */
+	gint		itemCountDelta;	/**< item count change not yet applied to the node */
+	gint		unreadCountDelta;	/**< unread count change not yet applied to the node */
 } *vfolderPtr;
 
 /**
@@ -73,13 +77,42 @@ typedef void 	(*vfolderActionDataFunc)	(vfolderPtr vfolder, itemPtr item);
 GSList * vfolder_get_all_with_item_id (itemPtr item);
 
 /**
- * Returns a list of all search folders currently not matching the given item.
+ * Notifies that the rules of a search folder were changed
+ * without resetting it. Causes the rules of all search folders
+ * to be compiled again on the next item update.
+ */
+void vfolder_rules_changed (void);
+
+/**
+ * Passes item counter changes caused by a single item update to the
+ * given search folder. The changes are applied on the next counter
+ * update, which is scheduled.
  *
- * @param item		the item
+ * @param id		the search folder node id
+ * @param itemCountDelta	change of the item count
+ * @param unreadCountDelta	change of the unread count
+ */
+void vfolder_item_counts_changed (const gchar *id, gint itemCountDelta, gint unreadCountDelta);
+
+/**
+ * Schedules a full recount of the given search folder. To be used
+ * after changes affecting many items at once. Can be passed to
+ * vfolder_foreach().
  *
- * @returns a list of vfolderPtr (to be free'd using g_slist_free())
+ * @param node		the search folder node
+ */
+void vfolder_recount (nodePtr node);
+
+/**
+ * Updates the item membership of all search folders after
+ * the given items were marked as read in the DB. Items are
+ * only loaded for search folders whose rules cannot be decided
+ * on the read state alone.
+ *
+ * @param items		hash table of item ids with their node ids
+ *			as returned by db_itemset_mark_read()
  */
-GSList * vfolder_get_all_without_item_id (itemPtr item);
+void vfolder_update_read_items (GHashTable *items);
 
 /**
  * Resets vfolder state. Drops all items from it.
@@ -30,7 +30,7 @@
 #define VFOLDER_LOADER_BATCH_SIZE 	100
 
 static gboolean
-vfolder_loader_fetch_cb (gpointer user_data, GSList **resultItems)
+vfolder_loader_fetch_cb (gpointer user_data, itemArenaPtr arena, GSList **resultItems)
 {
 	vfolderPtr	vfolder = (vfolderPtr)user_data;
 	itemSetPtr	items = g_new0 (struct itemSet, 1);
@@ -47,7 +47,7 @@ vfolder_loader_fetch_cb (gpointer user_data, GSList **resultItems)
 		while (iter) {
 			gulong id = GPOINTER_TO_UINT (iter->data);
 
-			itemPtr	item = db_item_load (id);
+			itemPtr	item = db_item_load_with_arena (id, arena);
 			if (itemset_check_item (vfolder->itemset, item))
 				*resultItems = g_slist_append (*resultItems, item);
 			else
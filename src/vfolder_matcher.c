@@ -0,0 +1,323 @@
+/**
+ * @file vfolder_matcher.c   matching items against all search folders at once
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "vfolder_matcher.h"
+
+#include <string.h>
+
+#include "debug.h"
+#include "itemset.h"
+#include "rule.h"
+
+/** automaton state with a complete transition table */
+typedef struct matcherState {
+	gint		next[256];	/**< next state for each input byte */
+	gint		fail;		/**< longest proper suffix state */
+	gint		output;		/**< next suffix state ending a pattern (0 if none) */
+	gint		pattern;	/**< pattern ending in this state (-1 if none) */
+} matcherState;
+
+/** compiled rule, not depending on the lifetime of the search folder rules */
+typedef struct matcherRule {
+	guint		textFields;	/**< fields to search, RULE_TEXT_NONE for predicate rules */
+	gint		index;		/**< pattern or predicate index */
+	gboolean	additive;
+} matcherRule;
+
+/** compiled search folder */
+typedef struct matcherFolder {
+	vfolderPtr	vfolder;
+	GArray		*rules;		/**< array of matcherRule */
+} matcherFolder;
+
+struct vfolderMatcher {
+	GArray		*states;	/**< array of matcherState, state 0 is the root */
+	guint		patternCount;
+	gint		emptyPattern;	/**< index of the empty search value (-1 if none) */
+	guint		textFields;	/**< union of all searched text fields */
+	GPtrArray	*predicates;	/**< distinct other rules (rulePtr copies) */
+	GArray		*folders;	/**< array of matcherFolder */
+};
+
+static gint
+vfolder_matcher_new_state (vfolderMatcherPtr matcher)
+{
+	matcherState	state;
+
+	memset (&state, 0, sizeof (state));
+	state.pattern = -1;
+	g_array_append_val (matcher->states, state);
+
+	return matcher->states->len - 1;
+}
+
+#define STATE(matcher, n) (&g_array_index ((matcher)->states, matcherState, (n)))
+
+static gint
+vfolder_matcher_add_pattern (vfolderMatcherPtr matcher, GHashTable *patterns, const gchar *value)
+{
+	gpointer	index;
+	const guchar	*p;
+	gint		state = 0;
+
+	if (g_hash_table_lookup_extended (patterns, value, NULL, &index))
+		return GPOINTER_TO_INT (index);
+
+	index = GINT_TO_POINTER (matcher->patternCount++);
+	g_hash_table_insert (patterns, (gpointer)value, index);
+
+	if (!*value) {
+		matcher->emptyPattern = GPOINTER_TO_INT (index);
+		return matcher->emptyPattern;
+	}
+
+	/* Extend the trie, during construction 0 means "no transition"
+	   as the root is never a target. */
+	for (p = (const guchar *)value; *p; p++) {
+		gint next = STATE (matcher, state)->next[*p];
+		if (!next) {
+			next = vfolder_matcher_new_state (matcher);
+			STATE (matcher, state)->next[*p] = next;
+		}
+		state = next;
+	}
+	STATE (matcher, state)->pattern = GPOINTER_TO_INT (index);
+
+	return GPOINTER_TO_INT (index);
+}
+
+static gint
+vfolder_matcher_add_predicate (vfolderMatcherPtr matcher, GHashTable *predicates, rulePtr rule)
+{
+	gpointer	index;
+	gchar		*key;
+	rulePtr		copy;
+
+	key = g_strdup_printf ("%s\n%s", rule->ruleInfo->ruleId, rule->value?rule->value:"");
+	if (g_hash_table_lookup_extended (predicates, key, NULL, &index)) {
+		g_free (key);
+		return GPOINTER_TO_INT (index);
+	}
+
+	copy = rule_new (rule->ruleInfo->ruleId, rule->value, TRUE);
+
+	index = GINT_TO_POINTER (matcher->predicates->len);
+	g_ptr_array_add (matcher->predicates, copy);
+	g_hash_table_insert (predicates, key, index);
+
+	return GPOINTER_TO_INT (index);
+}
+
+/* Turns the trie into the automaton by computing the failure links
+   breadth-first and completing all transition tables. */
+static void
+vfolder_matcher_compile (vfolderMatcherPtr matcher)
+{
+	GQueue	*queue = g_queue_new ();
+	guint	c;
+
+	for (c = 0; c < 256; c++) {
+		gint child = STATE (matcher, 0)->next[c];
+		if (child)
+			g_queue_push_tail (queue, GINT_TO_POINTER (child));
+	}
+
+	while (!g_queue_is_empty (queue)) {
+		gint		s = GPOINTER_TO_INT (g_queue_pop_head (queue));
+		matcherState	*state = STATE (matcher, s);
+		matcherState	*fail = STATE (matcher, state->fail);
+
+		for (c = 0; c < 256; c++) {
+			gint child = state->next[c];
+			if (child) {
+				matcherState *childState = STATE (matcher, child);
+
+				/* children of the root fail back to the root */
+				childState->fail = (s == 0)?0:fail->next[c];
+				if (STATE (matcher, childState->fail)->pattern >= 0)
+					childState->output = childState->fail;
+				else
+					childState->output = STATE (matcher, childState->fail)->output;
+				g_queue_push_tail (queue, GINT_TO_POINTER (child));
+			} else if (s != 0) {
+				state->next[c] = fail->next[c];
+			}
+		}
+	}
+
+	g_queue_free (queue);
+}
+
+vfolderMatcherPtr
+vfolder_matcher_new (GSList *vfolders)
+{
+	vfolderMatcherPtr	matcher;
+	GHashTable		*patterns, *predicates;
+	GSList			*iter, *riter;
+
+	debug_start_measurement (DEBUG_CACHE);
+
+	matcher = g_new0 (struct vfolderMatcher, 1);
+	matcher->states = g_array_new (FALSE, FALSE, sizeof (matcherState));
+	matcher->emptyPattern = -1;
+	matcher->predicates = g_ptr_array_new ();
+	matcher->folders = g_array_new (FALSE, FALSE, sizeof (matcherFolder));
+	vfolder_matcher_new_state (matcher);
+
+	/* patterns are keyed by the rule values which stay
+	   alive until the construction is finished */
+	patterns = g_hash_table_new (g_str_hash, g_str_equal);
+	predicates = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (iter = vfolders; iter; iter = g_slist_next (iter)) {
+		vfolderPtr	vfolder = (vfolderPtr)iter->data;
+		matcherFolder	folder;
+
+		folder.vfolder = vfolder;
+		folder.rules = g_array_new (FALSE, FALSE, sizeof (matcherRule));
+
+		for (riter = vfolder->itemset->rules; riter; riter = g_slist_next (riter)) {
+			rulePtr		rule = (rulePtr)riter->data;
+			matcherRule	compiled;
+
+			compiled.additive = rule->additive;
+			compiled.textFields = rule->ruleInfo->textFields;
+			if (compiled.textFields && rule->value) {
+				compiled.index = vfolder_matcher_add_pattern (matcher, patterns, rule->value);
+				matcher->textFields |= compiled.textFields;
+			} else {
+				compiled.textFields = RULE_TEXT_NONE;
+				compiled.index = vfolder_matcher_add_predicate (matcher, predicates, rule);
+			}
+			g_array_append_val (folder.rules, compiled);
+		}
+
+		g_array_append_val (matcher->folders, folder);
+	}
+
+	vfolder_matcher_compile (matcher);
+
+	debug4 (DEBUG_CACHE, "search folder matcher: %u search folders, %u patterns, %u states, %u other rules",
+	        matcher->folders->len, matcher->patternCount, matcher->states->len, matcher->predicates->len);
+
+	g_hash_table_destroy (patterns);
+	g_hash_table_destroy (predicates);
+
+	debug_end_measurement (DEBUG_CACHE, "search folder matcher setup");
+
+	return matcher;
+}
+
+static void
+vfolder_matcher_scan (vfolderMatcherPtr matcher, const gchar *text, gboolean *hits)
+{
+	matcherState	*states = (matcherState *)matcher->states->data;
+	const guchar	*p;
+	gint		state = 0, s;
+
+	/* like g_strstr_len() nothing is found in a missing text */
+	if (!text)
+		return;
+
+	if (matcher->emptyPattern >= 0)
+		hits[matcher->emptyPattern] = TRUE;
+
+	for (p = (const guchar *)text; *p; p++) {
+		state = states[state].next[*p];
+		for (s = state; s; s = states[s].output) {
+			if (states[s].pattern >= 0)
+				hits[states[s].pattern] = TRUE;
+		}
+	}
+}
+
+GSList *
+vfolder_matcher_match (vfolderMatcherPtr matcher, itemPtr item)
+{
+	GSList		*result = NULL;
+	gboolean	*titleHits, *descriptionHits;
+	gint8		*predicateResults;	/* 0 = not yet evaluated, 1 = no match, 2 = match */
+	guint		i, j;
+
+	titleHits = g_new0 (gboolean, 2 * matcher->patternCount + 1);
+	descriptionHits = titleHits + matcher->patternCount;
+	predicateResults = g_new0 (gint8, matcher->predicates->len + 1);
+
+	if (matcher->textFields & RULE_TEXT_TITLE)
+		vfolder_matcher_scan (matcher, item->title, titleHits);
+	if (matcher->textFields & RULE_TEXT_DESCRIPTION)
+		vfolder_matcher_scan (matcher, item->description, descriptionHits);
+
+	/* Combine the rule results exactly like itemset_check_item() does */
+	for (i = 0; i < matcher->folders->len; i++) {
+		matcherFolder	*folder = &g_array_index (matcher->folders, matcherFolder, i);
+		gboolean	anyMatch = folder->vfolder->itemset->anyMatch;
+		gboolean	matches = TRUE;
+
+		for (j = 0; j < folder->rules->len; j++) {
+			matcherRule	*rule = &g_array_index (folder->rules, matcherRule, j);
+			gboolean	ruleResult;
+
+			if (rule->textFields) {
+				ruleResult = ((rule->textFields & RULE_TEXT_TITLE) && titleHits[rule->index]) ||
+				             ((rule->textFields & RULE_TEXT_DESCRIPTION) && descriptionHits[rule->index]);
+			} else {
+				if (!predicateResults[rule->index]) {
+					rulePtr		predicate = g_ptr_array_index (matcher->predicates, rule->index);
+					ruleCheckFunc	func = predicate->ruleInfo->checkFunc;
+					predicateResults[rule->index] = (*func) (predicate, item)?2:1;
+				}
+				ruleResult = (2 == predicateResults[rule->index]);
+			}
+
+			matches &= rule->additive?ruleResult:!ruleResult;
+			if (anyMatch && matches)
+				break;
+		}
+
+		if (matches)
+			result = g_slist_prepend (result, folder->vfolder);
+	}
+
+	g_free (titleHits);
+	g_free (predicateResults);
+
+	return g_slist_reverse (result);
+}
+
+void
+vfolder_matcher_free (vfolderMatcherPtr matcher)
+{
+	guint	i;
+
+	if (!matcher)
+		return;
+
+	for (i = 0; i < matcher->folders->len; i++)
+		g_array_free (g_array_index (matcher->folders, matcherFolder, i).rules, TRUE);
+	g_array_free (matcher->folders, TRUE);
+
+	for (i = 0; i < matcher->predicates->len; i++)
+		rule_free (g_ptr_array_index (matcher->predicates, i));
+	g_ptr_array_free (matcher->predicates, TRUE);
+
+	g_array_free (matcher->states, TRUE);
+	g_free (matcher);
+}
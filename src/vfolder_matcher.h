@@ -0,0 +1,66 @@
+/**
+ * @file vfolder_matcher.h   matching items against all search folders at once
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _VFOLDER_MATCHER_H
+#define _VFOLDER_MATCHER_H
+
+#include <glib.h>
+
+#include "item.h"
+#include "vfolder.h"
+
+/* The search folder matcher compiles the rules of all search folders
+   into one matching structure. All plain substring search values are
+   put into one Aho-Corasick automaton, so item title and description
+   have to be scanned only once per item no matter how many search
+   folders and rules do exist. All other rules are evaluated at most
+   once per item for each distinct rule type and value. */
+
+typedef struct vfolderMatcher *vfolderMatcherPtr;
+
+/**
+ * Compiles the rules of the given search folders.
+ *
+ * @param vfolders	list of vfolderPtr
+ *
+ * @returns a new matcher
+ */
+vfolderMatcherPtr vfolder_matcher_new (GSList *vfolders);
+
+/**
+ * Returns all search folders matching the given item. The result
+ * is the same as checking the item against each search folder
+ * using itemset_check_item().
+ *
+ * @param matcher	the matcher
+ * @param item		the item
+ *
+ * @returns a list of vfolderPtr (to be free'd using g_slist_free())
+ */
+GSList * vfolder_matcher_match (vfolderMatcherPtr matcher, itemPtr item);
+
+/**
+ * Frees the given matcher.
+ *
+ * @param matcher	the matcher
+ */
+void vfolder_matcher_free (vfolderMatcherPtr matcher);
+
+#endif
@@ -191,6 +191,40 @@ liferea_webkit_write_html (
 				     content_type, "UTF-8", "file://");
 }
 
+/** Returns TRUE if the HTML view executes JavaScript */
+static gboolean
+liferea_webkit_scripts_enabled (GtkWidget *scrollpane)
+{
+	gboolean	scriptsEnabled;
+
+	g_object_get (settings, "enable-scripts", &scriptsEnabled, NULL);
+
+	return scriptsEnabled;
+}
+
+/**
+ * Run JavaScript code in the document currently displayed
+ *
+ * Fails if the last written document is not yet loaded
+ * or if scripts are disabled.
+ */
+static gboolean
+liferea_webkit_execute_script (GtkWidget *scrollpane, const gchar *script)
+{
+	WebKitWebView	*view;
+
+	view = WEBKIT_WEB_VIEW (gtk_bin_get_child (GTK_BIN (scrollpane)));
+
+	if (!liferea_webkit_scripts_enabled (scrollpane))
+		return FALSE;
+
+	if (WEBKIT_LOAD_FINISHED != webkit_web_view_get_load_status (view))
+		return FALSE;
+
+	webkit_web_view_execute_script (view, script);
+	return TRUE;
+}
+
 static void
 liferea_webkit_title_changed (WebKitWebView *view, GParamSpec *pspec, gpointer user_data)
 {
@@ -373,7 +407,8 @@ liferea_webkit_on_menu (WebKitWebView *view, GtkMenu *menu)
  * WebKitWebView::console-message:
  * A JavaScript console message was created.
  *
- * And we ignore them.
+ * Internal documents use them to talk to Liferea,
+ * all others are ignored.
  */
 static gboolean
 liferea_webkit_javascript_message  (WebKitWebView *view,
@@ -381,9 +416,35 @@ liferea_webkit_javascript_message  (WebKitWebView *view,
 				    int line,
 				    const char *source_id)
 {
+	liferea_htmlview_on_script_message (g_object_get_data (G_OBJECT (view), "htmlview"), message);
+
 	return TRUE;
 }
 
+/**
+ * WebKitWebView::resource-request-starting:
+ * A resource (e.g. an image) is about to be loaded.
+ *
+ * Serves cached item images from the local image cache.
+ */
+static void
+liferea_webkit_resource_request_starting (WebKitWebView *view,
+					  WebKitWebFrame *frame,
+					  WebKitWebResource *resource,
+					  WebKitNetworkRequest *request,
+					  WebKitNetworkResponse *response,
+					  gpointer user_data)
+{
+	gchar	*uri;
+
+	uri = liferea_htmlview_get_local_resource (g_object_get_data (G_OBJECT (view), "htmlview"),
+	                                           webkit_network_request_get_uri (request));
+	if (uri) {
+		webkit_network_request_set_uri (request, uri);
+		g_free (uri);
+	}
+}
+
 /**
  * Initializes WebKit
  *
@@ -477,6 +538,12 @@ liferea_webkit_new (LifereaHtmlView *htmlview)
 		G_CALLBACK (webkit_create_web_view),
 		view
 	);
+	g_signal_connect (
+		view,
+		"resource-request-starting",
+		G_CALLBACK (liferea_webkit_resource_request_starting),
+		view
+	);
 
 	gtk_widget_show (GTK_WIDGET (view));
 	return scrollpane;
@@ -613,6 +680,8 @@ htmlviewImpl webkitImpl = {
 	.init		= liferea_webkit_init,
 	.create		= liferea_webkit_new,
 	.write		= liferea_webkit_write_html,
+	.executeScript	= liferea_webkit_execute_script,
+	.scriptsEnabled	= liferea_webkit_scripts_enabled,
 	.launch		= liferea_webkit_launch_url,
 	.zoomLevelGet	= liferea_webkit_get_zoom_level,
 	.zoomLevelSet	= liferea_webkit_change_zoom_level,
@@ -37,6 +37,11 @@
 
 static void xml_buffer_parse_error(void *ctxt, const gchar * msg, ...);
 
+/* One HTML parser context is reused for all item content parsing
+   (which happens in the main thread only). It keeps its dictionary,
+   so element and attribute names are interned once for all items. */
+static htmlParserCtxtPtr htmlParser = NULL;
+
 static xmlDocPtr
 xhtml_parse (const gchar *html, gint len)
 {
@@ -44,39 +49,36 @@ xhtml_parse (const gchar *html, gint len)
 	
 	g_assert (html != NULL);
 	g_assert (len >= 0);
+
+	if (!htmlParser) {
+		htmlParser = htmlNewParserCtxt ();
+		if (!htmlParser)
+			return NULL;
+	}
 	
 	/* Note: NONET is not implemented so it will return an error
 	   because it doesn't know how to handle NONET. But, it might
 	   learn in the future. */
-	out = htmlReadMemory (html, len, NULL, "utf-8", HTML_PARSE_RECOVER | HTML_PARSE_NONET |
-	                      ((debug_level & DEBUG_HTML)?0:(HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING)));
+	out = htmlCtxtReadMemory (htmlParser, html, len, NULL, "utf-8", HTML_PARSE_RECOVER | HTML_PARSE_NONET |
+	                          ((debug_level & DEBUG_HTML)?0:(HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING)));
 	return out;
 }
 
-static xmlNodePtr
+xmlNodePtr
 xhtml_find_body (xmlDocPtr doc)
 {
-	xmlXPathContextPtr xpathCtxt = NULL;
-	xmlXPathObjectPtr xpathObj = NULL;
-	xmlNodePtr node = NULL;
+	xmlNodePtr	node;
 
-	xpathCtxt = xmlXPathNewContext (doc);
-	if (!xpathCtxt)
-		goto error;
+	node = xmlDocGetRootElement (doc);
+	if (!node || xmlStrcmp (node->name, BAD_CAST"html"))
+		return NULL;
 
-	xpathObj = xmlXPathEvalExpression ("/html/body", xpathCtxt);
-	if (!xpathObj)
-		goto error;
-	if (!xpathObj->nodesetval->nodeMax)
-		goto error;
-	
-	node = xpathObj->nodesetval->nodeTab[0];
- error:
-	if (xpathObj)
-		xmlXPathFreeObject (xpathObj);
-	if (xpathCtxt)
-		xmlXPathFreeContext (xpathCtxt);
-	return node;
+	for (node = node->children; node; node = node->next) {
+		if ((XML_ELEMENT_NODE == node->type) && !xmlStrcmp (node->name, BAD_CAST"body"))
+			return node;
+	}
+
+	return NULL;
 }
 
 gchar *
@@ -104,7 +106,7 @@ xhtml_extract (xmlNodePtr xml, gint xhtmlMode, const gchar *defaultBase)
 	
 	if (xhtmlMode == 0) { /* Read escaped HTML and convert to XHTML, placing in a div tag */
 		xmlDocPtr oldDoc;
-		xmlNodePtr copiedNodes = NULL;
+		xmlNodePtr movedNodes = NULL;
 		xmlChar *escapedhtml;
 		
 		/* Parse the HTML into oldDoc*/
@@ -140,12 +142,22 @@ xhtml_extract (xmlNodePtr xml, gint xhtmlMode, const gchar *defaultBase)
 					ns = ns->next;
 				}
 				
-				if (body) {
-					/* Copy in the html tags */
-					copiedNodes = xmlDocCopyNodeList (newDoc, body->xmlChildrenNode);
-					// FIXME: is the above correct? Why only operate on the first child node?
-					// It might be unproblematic because all content is wrapped in a <div>...
-					xmlAddChildList (divNode, copiedNodes);
+				if (body && body->xmlChildrenNode) {
+					/* Move the html tags instead of copying them, the
+					   parsed document is dropped anyway. The new document
+					   needs to share the parser dictionary the node names
+					   and some text content are allocated from. Still it
+					   is a XML document, so the content is dumped as XHTML. */
+					if (oldDoc->dict) {
+						newDoc->dict = oldDoc->dict;
+						xmlDictReference (newDoc->dict);
+					}
+
+					movedNodes = body->xmlChildrenNode;
+					body->xmlChildrenNode = NULL;
+					body->last = NULL;
+					xmlSetListDoc (movedNodes, newDoc);
+					xmlAddChildList (divNode, movedNodes);
 				}
 				xmlFreeDoc (oldDoc);
 				xmlFree (escapedhtml);
@@ -194,6 +206,46 @@ xhtml_extract_from_string (const gchar *html, const gchar *defaultBase)
 	return result;
 }
 
+static void
+xhtml_collect_image_urls (xmlNodePtr node, const gchar *baseURL, GSList **urls)
+{
+	xmlChar	*src;
+
+	for (; node; node = node->next) {
+		if (XML_ELEMENT_NODE != node->type)
+			continue;
+
+		if (!xmlStrcasecmp (node->name, BAD_CAST"img")) {
+			src = xmlGetProp (node, BAD_CAST"src");
+			if (src) {
+				*urls = g_slist_prepend (*urls, common_build_url ((gchar *)src, baseURL));
+				xmlFree (src);
+			}
+		}
+
+		xhtml_collect_image_urls (node->children, baseURL, urls);
+	}
+}
+
+GSList *
+xhtml_get_image_urls (const gchar *html, const gchar *baseURL)
+{
+	xmlDocPtr	doc;
+	GSList		*urls = NULL;
+
+	if (!html || !*html)
+		return NULL;
+
+	doc = xhtml_parse (html, strlen (html));
+	if (!doc)
+		return NULL;
+
+	xhtml_collect_image_urls (xmlDocGetRootElement (doc), baseURL, &urls);
+	xmlFreeDoc (doc);
+
+	return g_slist_reverse (urls);
+}
+
 gboolean
 xhtml_is_well_formed (const gchar *data)
 {
@@ -222,70 +274,168 @@ xhtml_is_well_formed (const gchar *data)
 	return result;
 }
 
-static GSList *dhtml_strippers = NULL;
-static GSList *unsupported_tag_strippers = NULL;
+/* HTML stripping is done in a single pass over the string. It strips
+   the same constructs as the case insensitive and ungreedy regular
+   expressions used before:
 
-static void
-xhtml_stripper_add (GSList **strippers, const gchar *pattern)
+   DHTML:		\s+onload='[^']+'
+   			\s+onload="[^"]+"
+   			<\s*script\s*>.*</\s*script\s*>
+   			<\s*meta\s*>.*</\s*meta\s*>
+   			<\s*iframe[^>]*\s*>.*</\s*iframe\s*>
+
+   unsupported tags:	all start and end tags of "wbr" and "body"
+   			(up to the first '>')
+ */
+
+#define XHTML_STRIP_DHTML		(1<<0)
+#define XHTML_STRIP_UNSUPPORTED_TAGS	(1<<1)
+
+static const gchar *
+xhtml_skip_space (const gchar *p)
 {
-	GError *err = NULL;
-	GRegex *expr;
-	
-	expr = g_regex_new (pattern, G_REGEX_CASELESS | G_REGEX_UNGREEDY | G_REGEX_DOTALL | G_REGEX_OPTIMIZE, 0, &err);
-	if (err) {
-		g_warning ("xhtml_strip_setup: %s\n", err->message);
-		g_error_free (err);
-		return;
+	while (*p && g_ascii_isspace (*p))
+		p++;
+	return p;
+}
+
+/* Returns the position after the case insensitive keyword or NULL */
+static const gchar *
+xhtml_skip_keyword (const gchar *p, const gchar *keyword)
+{
+	gsize	length = strlen (keyword);
+
+	return (0 == g_ascii_strncasecmp (p, keyword, length))?p + length:NULL;
+}
+
+/* Matches whitespace followed by an onload attribute */
+static const gchar *
+xhtml_match_onload (const gchar *p)
+{
+	const gchar	*end;
+
+	p = xhtml_skip_keyword (xhtml_skip_space (p), "onload=");
+	if (!p || (('\'' != *p) && ('"' != *p)))
+		return NULL;
+
+	end = strchr (p + 1, *p);
+	if (!end || (end == p + 1))
+		return NULL;
+
+	return end + 1;
+}
+
+/* Matches an element with all its content up to the first end tag */
+static const gchar *
+xhtml_match_element (const gchar *p, const gchar *name, gboolean attributes)
+{
+	const gchar	*end;
+
+	p = xhtml_skip_keyword (xhtml_skip_space (p + 1), name);
+	if (!p)
+		return NULL;
+
+	if (attributes)
+		p = strchr (p, '>');
+	else
+		p = xhtml_skip_space (p);
+	if (!p || ('>' != *p))
+		return NULL;
+
+	for (p++; NULL != (p = strstr (p, "</")); p += 2) {
+		end = xhtml_skip_keyword (xhtml_skip_space (p + 2), name);
+		if (end) {
+			end = xhtml_skip_space (end);
+			if ('>' == *end)
+				return end + 1;
+		}
 	}
-	*strippers = g_slist_append (*strippers, expr);
+
+	return NULL;
+}
+
+/* Matches a start or end tag */
+static const gchar *
+xhtml_match_tag (const gchar *p, const gchar *name)
+{
+	p = xhtml_skip_space (p + 1);
+	if ('/' == *p)
+		p++;
+
+	p = xhtml_skip_keyword (p, name);
+	if (!p)
+		return NULL;
+
+	p = strchr (p, '>');
+	return p?p + 1:NULL;
 }
 
 static gchar *
-xhtml_strip (const gchar *html, GSList *strippers)
-{
-	gchar *result = g_strdup (html);
-	GSList *iter = strippers;
-	
-	while (iter) {
-		GError *err = NULL;
-		GRegex *expr = (GRegex *)iter->data;
-		gchar *tmp = result;
-		result = g_regex_replace (expr, tmp, -1, 0, "", 0, &err);
-		if (err) {
-			g_warning ("xhtml_strip: %s\n", err->message);
-			g_error_free (err);
-			err = NULL;
+xhtml_strip (const gchar *html, guint flags)
+{
+	GString		*result;
+	const gchar	*p, *copied, *end;
+
+	if (!html)
+		return NULL;
+
+	result = g_string_sized_new (strlen (html));
+	p = copied = html;
+	while (*p) {
+		end = NULL;
+
+		if (g_ascii_isspace (*p)) {
+			if (flags & XHTML_STRIP_DHTML)
+				end = xhtml_match_onload (p);
+			if (!end) {
+				/* no match for the rest of the whitespace run either */
+				p = xhtml_skip_space (p);
+				continue;
+			}
+		} else if ('<' == *p) {
+			if (flags & XHTML_STRIP_DHTML) {
+				end = xhtml_match_element (p, "script", FALSE);
+				if (!end)
+					end = xhtml_match_element (p, "meta", FALSE);
+				if (!end)
+					end = xhtml_match_element (p, "iframe", TRUE);
+			}
+			if (flags & XHTML_STRIP_UNSUPPORTED_TAGS) {
+				if (!end)
+					end = xhtml_match_tag (p, "wbr");
+				if (!end)
+					end = xhtml_match_tag (p, "body");
+			}
+		}
+
+		if (end) {
+			g_string_append_len (result, copied, p - copied);
+			p = copied = end;
+		} else {
+			p++;
 		}
-		g_free (tmp);
-		iter = g_slist_next (iter);
 	}
+	g_string_append_len (result, copied, p - copied);
 
-	return result;
+	return g_string_free (result, FALSE);
 }
 
 gchar *
 xhtml_strip_dhtml (const gchar *html)
 {
-	if (!dhtml_strippers) {
-		xhtml_stripper_add (&dhtml_strippers, "\\s+onload='[^']+'");
-		xhtml_stripper_add (&dhtml_strippers, "\\s+onload=\"[^\"]+\"");
-		xhtml_stripper_add (&dhtml_strippers, "<\\s*script\\s*>.*</\\s*script\\s*>");
-		xhtml_stripper_add (&dhtml_strippers, "<\\s*meta\\s*>.*</\\s*meta\\s*>");
-		xhtml_stripper_add (&dhtml_strippers, "<\\s*iframe[^>]*\\s*>.*</\\s*iframe\\s*>");
-	}
-	
-	return xhtml_strip (html, dhtml_strippers);
+	return xhtml_strip (html, XHTML_STRIP_DHTML);
 }
 
 gchar *
 xhtml_strip_unsupported_tags (const gchar *html)
 {
-	if (!unsupported_tag_strippers) {
-		xhtml_stripper_add(&unsupported_tag_strippers, "<\\s*/?wbr[^>]*/?\\s*>");
-		xhtml_stripper_add(&unsupported_tag_strippers, "<\\s*/?body[^>]*/?\\s*>");
-	}
-	
-	return xhtml_strip(html, unsupported_tag_strippers);
+	return xhtml_strip (html, XHTML_STRIP_UNSUPPORTED_TAGS);
+}
+
+gchar *
+xhtml_strip_dhtml_and_unsupported_tags (const gchar *html)
+{
+	return xhtml_strip (html, XHTML_STRIP_DHTML | XHTML_STRIP_UNSUPPORTED_TAGS);
 }
 
 typedef struct {
@@ -511,6 +661,53 @@ xml_get_ns_attribute (xmlNodePtr node, const gchar *name, const gchar *namespace
 	return xmlGetNsProp (node, BAD_CAST name, BAD_CAST namespace);
 }
 
+/* Render key output appends each name and value including its
+   terminator, so consecutive strings cannot be shifted against
+   each other. A NULL value is kept apart from an empty one. */
+static void
+xml_render_key_append (GString *key, const gchar *str)
+{
+	if (str)
+		g_string_append_len (key, str, strlen (str) + 1);
+	else
+		g_string_append_c (key, '\001');
+}
+
+xmlNodePtr
+xml_add_child (xmlNodePtr node, GString *key, const gchar *name)
+{
+	if (key) {
+		xml_render_key_append (key, name);
+		return NULL;
+	}
+
+	return xmlNewChild (node, NULL, BAD_CAST name, NULL);
+}
+
+xmlNodePtr
+xml_add_text_child (xmlNodePtr node, GString *key, const gchar *name, const gchar *content)
+{
+	if (key) {
+		xml_render_key_append (key, name);
+		xml_render_key_append (key, content);
+		return NULL;
+	}
+
+	return xmlNewTextChild (node, NULL, BAD_CAST name, BAD_CAST content);
+}
+
+void
+xml_add_attribute (xmlNodePtr node, GString *key, const gchar *name, const gchar *value)
+{
+	if (key) {
+		xml_render_key_append (key, name);
+		xml_render_key_append (key, value);
+		return;
+	}
+
+	xmlNewProp (node, BAD_CAST name, BAD_CAST value);
+}
+
 xmlDocPtr
 xml_parse (gchar *data, size_t length, errorCtxtPtr errCtx)
 {
@@ -77,6 +77,15 @@ gchar * xhtml_extract_from_string (const gchar *html, const gchar *nodeBase);
  */
 gchar * xhtml_extract (xmlNodePtr cur, gint xhtmlMode, const gchar *defaultBase);
 
+/**
+ * Returns the body element of a (X)HTML document.
+ *
+ * @param doc	the document
+ *
+ * @returns the node matching "/html/body" (or NULL)
+ */
+xmlNodePtr xhtml_find_body (xmlDocPtr doc);
+
 /**
  * Strips some DHTML constructs from the given HTML string.
  *
@@ -96,6 +105,34 @@ gchar * xhtml_strip_dhtml (const gchar *html);
  */
 gchar * xhtml_strip_unsupported_tags (const gchar *html);
 
+/**
+ * Version of the stripping rules applied by
+ * xhtml_strip_dhtml_and_unsupported_tags(). Item descriptions are
+ * stored stripped together with this version, so it has to be
+ * increased whenever the rules change to get old items stripped again.
+ */
+#define XHTML_STRIP_VERSION	1
+
+/**
+ * Does both xhtml_strip_dhtml() and xhtml_strip_unsupported_tags()
+ * in a single pass.
+ *
+ * @param html	some HTML content
+ *
+ * @return newly allocated stripped HTML string
+ */
+gchar * xhtml_strip_dhtml_and_unsupported_tags (const gchar *html);
+
+/**
+ * Returns the URLs of all images of the given HTML content.
+ *
+ * @param html		some HTML content
+ * @param baseURL	base URL for relative image URLs (or NULL)
+ *
+ * @returns a list of absolute URLs (to be free'd using g_free)
+ */
+GSList * xhtml_get_image_urls (const gchar *html, const gchar *baseURL);
+
 /**
  * Checks the given string for XHTML well formedness.
  *
@@ -149,6 +186,44 @@ gchar * xml_get_attribute (xmlNodePtr node, const gchar *name);
  */
 gchar * xml_get_ns_attribute (xmlNodePtr node, const gchar *name, const gchar *namespace);
 
+/* The following helpers let serializers used for rendering (e.g.
+   item_to_xml()) also compute render cache keys: given a key they
+   append the name and content of the node to the key instead of
+   creating it, so the key covers exactly what would be serialized. */
+
+/**
+ * Adds a child node or appends its name to the given key.
+ *
+ * @param node		parent XML node (ignored if key is given)
+ * @param key		render key to append to (or NULL)
+ * @param name		node name
+ *
+ * @returns the new node (or NULL if a key is given)
+ */
+xmlNodePtr xml_add_child (xmlNodePtr node, GString *key, const gchar *name);
+
+/**
+ * Adds a text child node or appends its name and content to the given key.
+ *
+ * @param node		parent XML node (ignored if key is given)
+ * @param key		render key to append to (or NULL)
+ * @param name		node name
+ * @param content	text content (or NULL)
+ *
+ * @returns the new node (or NULL if a key is given)
+ */
+xmlNodePtr xml_add_text_child (xmlNodePtr node, GString *key, const gchar *name, const gchar *content);
+
+/**
+ * Adds an attribute or appends its name and value to the given key.
+ *
+ * @param node		XML node (ignored if key is given)
+ * @param key		render key to append to (or NULL)
+ * @param name		attribute name
+ * @param value		attribute value
+ */
+void xml_add_attribute (xmlNodePtr node, GString *key, const gchar *name, const gchar *value);
+
 /** used to keep track of error messages during parsing */
 typedef struct errorCtxt {
 	GString		*msg;		/**< message buffer */
@@ -0,0 +1,115 @@
+/**
+ * @file parse_date.c  checks the RFC822 and ISO8601 date parsers
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <glib.h>
+
+#include "date.h"
+
+/* Real-world date variants as found in feeds. The parsers must not
+   depend on the local time zone, so all variants are checked in
+   several time zones. A result of 0 means the date is rejected. */
+
+typedef struct dateCase {
+	gboolean	iso8601;	/**< TRUE for ISO8601, FALSE for RFC822 */
+	const gchar	*date;		/**< the date string as found in a feed */
+	gint64		expected;	/**< expected UTC time */
+} dateCase;
+
+static const dateCase cases[] = {
+	{ TRUE,  "2003-08-07T15:28:19Z",		1060270099 },
+	{ TRUE,  "2003-08-07T15:28:19+02:00",		1060262899 },
+	{ TRUE,  "2003-08-07T15:28:19-0530",		1060289899 },
+	{ TRUE,  "2003-08-07T15:28:19.123456Z",		1060270099 },
+	{ TRUE,  "2003-08-07T15:28Z",			1060270080 },
+	{ TRUE,  "2003-08-07T15:28:19",			1060270099 },	/* no zone means UTC */
+	{ TRUE,  "2003-08-07",				1060214400 },
+	{ TRUE,  " 2003-08-07T15:28:19+02",		1060262899 },
+	{ TRUE,  "2003-08-07 15:28:19",			1060270099 },
+	{ TRUE,  "2012-07-15T12:00:00+01:00",		1342350000 },
+	{ TRUE,  "2012-02-29T23:59:59Z",		1330559999 },
+	{ TRUE,  "2000-02-29T00:00:00Z",		951782400 },
+	{ TRUE,  "1969-12-31T23:59:59Z",		-1 },
+	{ TRUE,  "1900-01-01T00:00:00Z",		-2208988800LL },
+	{ TRUE,  "2038-01-19T03:14:08Z",		2147483648LL },
+	{ TRUE,  "2100-03-01T00:00:00Z",		4107542400LL },
+	{ TRUE,  "2003-8-7T5:3:9Z",			1060232589 },
+	{ TRUE,  "2003-02-30T00:00:00Z",		1046563200 },	/* normalized like mktime() */
+	{ TRUE,  "garbage",				0 },
+	{ TRUE,  "2003-13-01",				0 },
+	{ TRUE,  "",					0 },
+	{ TRUE,  "2003-08-07T25:00:00Z",		1060214400 },	/* invalid time, date only */
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34 +0100",	1354495114 },
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34 GMT",	1354498714 },
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34 EST",	1354516714 },
+	{ FALSE, "Sun, 15 Jul 2012 12:00:00 EDT",	1342368000 },
+	{ FALSE, "Sun, 15 Jul 2012 12:00:00 PDT",	1342378800 },
+	{ FALSE, "03 Dec 2012 01:38:34 CET",		1354495114 },
+	{ FALSE, "3 Dec 2012 01:38 +0000",		1354498680 },
+	{ FALSE, "Fri, 03 Dec 12 01:38:34 CET",		1354495114 },	/* 2-digit years */
+	{ FALSE, "Fri, 03 Dec 99 01:38:34 GMT",		944185114 },
+	{ FALSE, "Mon, 03 december 2012 01:38:34 UT",	1354498714 },
+	{ FALSE, "Mon, 03 DEC 2012 01:38:34 UTC",	1354498714 },
+	{ FALSE, "Mon,03 Dec 2012 01:38:34 -0800",	1354527514 },
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34",		1354498714 },	/* no zone means UTC */
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34 (CET)",	1354495114 },
+	{ FALSE, "Mon, 03 Dec 2012 01:38:34 +05:30",	1354478914 },
+	{ FALSE, "Tue, 29 Feb 2000 12:00:00 Z",		951825600 },
+	{ FALSE, "Mon, 03 Foo 2012 01:38:34 GMT",	0 },
+	{ FALSE, "Mon, 03 Dec 2012",			0 },
+	{ FALSE, "garbage",				0 }
+};
+
+static const gchar *zones[] = { "UTC", "Europe/Berlin", "America/New_York", "Asia/Kolkata" };
+
+int
+main (int argc, char **argv)
+{
+	guint	i, j, failed = 0;
+
+	for (i = 0; i < G_N_ELEMENTS (zones); i++) {
+		g_setenv ("TZ", zones[i], TRUE);
+		tzset ();
+
+		for (j = 0; j < G_N_ELEMENTS (cases); j++) {
+			const dateCase	*c = &cases[j];
+			gint64		result;
+
+			if (c->iso8601)
+				result = (gint64)date_parse_ISO8601 (c->date);
+			else
+				result = (gint64)date_parse_RFC822 (c->date);
+
+			if (result != c->expected) {
+				g_printerr ("%s: %s date \"%s\" parsed as %" G_GINT64_FORMAT ", expected %" G_GINT64_FORMAT "\n",
+				            zones[i], c->iso8601?"ISO8601":"RFC822", c->date, result, c->expected);
+				failed++;
+			}
+		}
+	}
+
+	if (failed) {
+		g_printerr ("%u of %u date checks failed\n", failed, (guint)(G_N_ELEMENTS (zones) * G_N_ELEMENTS (cases)));
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file strcasestr.c  checks the vector case insensitive substring
+ *                     searches against the scalar one
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <glib.h>
+
+#include "common.h"
+
+/* All implementations must agree with the expected match offset for
+   every alignment of the haystack, including matches in the last
+   bytes of a vector block and right before the terminating zero.
+   An offset of -1 means no match. */
+
+typedef char * (*strcasestrFunc) (const char *phaystack, const char *pneedle);
+
+typedef struct searchImpl {
+	const gchar	*name;
+	strcasestrFunc	func;
+	gboolean	vector;		/**< TRUE if the needle must start with two ASCII characters */
+} searchImpl;
+
+typedef struct searchCase {
+	const gchar	*haystack;
+	const gchar	*needle;
+	gint		expected;	/**< expected match offset */
+} searchCase;
+
+static const searchCase cases[] = {
+	{ "",						"a",		-1 },
+	{ "a",						"a",		0 },
+	{ "A",						"a",		0 },
+	{ "a",						"ab",		-1 },	/* needle longer than haystack */
+	{ "Liferea",					"FEREA",	2 },
+	{ "Liferea",					"liferea",	0 },
+	{ "Liferea",					"lifereas",	-1 },
+	{ "0123456789abcdef",				"eF",		14 },	/* end of a 16 byte block */
+	{ "0123456789abcdefghijklmnopqrstUV",		"uv",		30 },	/* end of a 32 byte block */
+	{ "0123456789abcdefghijklmnopqrstUV",		"F",		15 },
+	{ "0123456789abcdef0123456789ABCDEx",		"X",		31 },	/* last byte */
+	{ "0123456789abcdef0123456789ABCDE",		"ex",		-1 },	/* partial match at the end */
+	{ "0123456789abcdef0",				"F0",		15 },	/* match crossing blocks */
+	{ "0123456789abcdefghijklmnopqrstuvW",	"Vw",		31 },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab",	"AAB",		33 },
+	{ "abababababababababababababababababac",	"abac",		32 },
+	{ "@@@@````[[[[{{{{",				"`{",		-1 },	/* non-letters differing by 0x20 */
+	{ "@@@@````[[[[{{{{",				"[{",		11 },
+	{ "@@@@````[[[[{{{{",				"@`",		3 },
+	{ "@@@@````[[[[{{{{",				"``",		4 },
+	{ "<SCRIPT type=\"text/javascript\">",		"<script",	0 },
+	{ "some text <IFrame src=\"x\">",		"<iframe",	10 },
+	{ "caf\xc3\xa9 au lait",			"AU",		6 },
+	{ "caf\xc3\xa9 au lait",			"\xc3\xa9",	3 },	/* non-ASCII needle */
+	{ "line\nbreak\ttab",				"\tTAB",	10 },
+	{ "only one at the very end: needle",		"NEEDLE",	26 },
+	{ "no match at the very end: needl",		"eedlex",	-1 }
+};
+
+/* Copies the haystack so that it ends directly before an unmapped
+   page. A vector scan reading past the terminating zero into the
+   next page crashes here. */
+static gchar *
+guard_page_copy (gchar *pages, gsize pagesize, const gchar *haystack)
+{
+	gsize	len = strlen (haystack) + 1;
+	gchar	*copy = pages + pagesize - len;
+
+	memcpy (copy, haystack, len);
+	return copy;
+}
+
+static gint
+search_offset (strcasestrFunc func, const gchar *haystack, const gchar *needle)
+{
+	const gchar *result = func (haystack, needle);
+
+	return result ? (gint)(result - haystack) : -1;
+}
+
+static gboolean
+needle_is_ascii (const gchar *needle)
+{
+	return !(needle[0] & 0x80) && (!needle[0] || !(needle[1] & 0x80));
+}
+
+int
+main (int argc, char **argv)
+{
+	searchImpl	impls[3];
+	guint		nImpls = 0, i, j, checks = 0, failed = 0;
+	gsize		pagesize = (gsize)sysconf (_SC_PAGESIZE);
+	gchar		*pages, *buffer;
+	GRand		*rand;
+
+	impls[nImpls].name = "scalar";
+	impls[nImpls].func = common_strcasestr_scalar;
+	impls[nImpls++].vector = FALSE;
+#ifdef COMMON_STRCASESTR_X86
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("sse2")) {
+		impls[nImpls].name = "SSE2";
+		impls[nImpls].func = common_strcasestr_sse2;
+		impls[nImpls++].vector = TRUE;
+	}
+	if (__builtin_cpu_supports ("avx2")) {
+		impls[nImpls].name = "AVX2";
+		impls[nImpls].func = common_strcasestr_avx2;
+		impls[nImpls++].vector = TRUE;
+	}
+#endif
+
+	pages = mmap (NULL, 2 * pagesize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pages == MAP_FAILED || mprotect (pages + pagesize, pagesize, PROT_NONE)) {
+		g_printerr ("could not set up the guard page\n");
+		return EXIT_FAILURE;
+	}
+	buffer = g_malloc (256);
+
+	/* known cases at all alignments of a 32 byte block */
+	for (i = 0; i < G_N_ELEMENTS (cases); i++) {
+		const searchCase *c = &cases[i];
+
+		for (j = 0; j < nImpls; j++) {
+			guint align;
+
+			if (impls[j].vector && !needle_is_ascii (c->needle))
+				continue;
+
+			for (align = 0; align < 64; align++) {
+				gint result;
+
+				strcpy (buffer + align, c->haystack);
+				result = search_offset (impls[j].func, buffer + align, c->needle);
+				checks++;
+				if (result != c->expected) {
+					g_printerr ("%s: \"%s\" in \"%s\" at alignment %u found at %d, expected %d\n",
+					            impls[j].name, c->needle, c->haystack, align, result, c->expected);
+					failed++;
+				}
+			}
+
+			checks++;
+			if (search_offset (impls[j].func, guard_page_copy (pages, pagesize, c->haystack), c->needle) != c->expected) {
+				g_printerr ("%s: \"%s\" in \"%s\" before a page boundary not found at %d\n",
+				            impls[j].name, c->needle, c->haystack, c->expected);
+				failed++;
+			}
+		}
+
+		checks++;
+		if (search_offset (common_strcasestr, c->haystack, c->needle) != c->expected) {
+			g_printerr ("dispatch: \"%s\" in \"%s\" not found at %d\n", c->needle, c->haystack, c->expected);
+			failed++;
+		}
+	}
+
+	/* an empty needle matches the start of any haystack */
+	checks += 2;
+	if (search_offset (common_strcasestr, "Liferea", "") != 0 ||
+	    search_offset (common_strcasestr, "", "") != 0) {
+		g_printerr ("dispatch: empty needle does not match at 0\n");
+		failed++;
+	}
+
+	/* random haystacks of few characters produce many partial matches,
+	   each placed right before the guard page and compared with the
+	   scalar search */
+	rand = g_rand_new_with_seed (42);
+	for (i = 0; i < 20000; i++) {
+		static const gchar	alphabet[] = "aAbB@`[{ \xc3";
+		gchar			haystack[200], needle[5];
+		gint			hlen = g_rand_int_range (rand, 0, sizeof (haystack));
+		gint			nlen = g_rand_int_range (rand, 1, sizeof (needle));
+		gint			k, expected;
+		const gchar		*guarded;
+
+		for (k = 0; k < hlen; k++)
+			haystack[k] = alphabet[g_rand_int_range (rand, 0, sizeof (alphabet) - 1)];
+		haystack[hlen] = 0;
+		for (k = 0; k < nlen; k++)
+			needle[k] = alphabet[g_rand_int_range (rand, 0, sizeof (alphabet) - 2)];
+		needle[nlen] = 0;
+
+		guarded = guard_page_copy (pages, pagesize, haystack);
+		expected = search_offset (common_strcasestr_scalar, guarded, needle);
+		for (j = 1; j < nImpls; j++) {
+			gint result = search_offset (impls[j].func, guarded, needle);
+
+			checks++;
+			if (result != expected) {
+				g_printerr ("%s: \"%s\" in \"%s\" found at %d, scalar found it at %d\n",
+				            impls[j].name, needle, haystack, result, expected);
+				failed++;
+			}
+		}
+	}
+	g_rand_free (rand);
+
+	g_free (buffer);
+	munmap (pages, 2 * pagesize);
+
+	if (failed) {
+		g_printerr ("%u of %u search checks failed\n", failed, checks);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file strip_html.c  checks the DHTML and unsupported tag stripping
+ *
+ * Copyright (C) 2012 Lars Windolf <lars.lindner@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+
+#include "xml.h"
+
+/* Item description variants as found in feeds together with the
+   result expected from xhtml_strip_dhtml_and_unsupported_tags(). */
+
+typedef struct stripCase {
+	const gchar	*html;		/**< the description as found in a feed */
+	const gchar	*expected;	/**< expected stripped description */
+} stripCase;
+
+static const stripCase cases[] = {
+	{ "",								"" },
+	{ "<p>plain <b>text</b></p>",					"<p>plain <b>text</b></p>" },
+	{ "a<script>alert(1)</script>b",				"ab" },
+	{ "a<SCRIPT>alert(1)</SCRIPT>b",				"ab" },
+	{ "a<ScRiPt>alert(1)</sCrIpT>b",				"ab" },
+	{ "a< script >alert(1)</ script >b",				"ab" },
+	{ "a<script\n>alert(1)</script\t>b",				"ab" },
+	{ "<script>1</script>a<script>2</script>b",			"ab" },		/* up to the first end tag */
+	{ "a<script>never closed",					"a<script>never closed" },
+	{ "a<scripts>x</scripts>b",					"a<scripts>x</scripts>b" },
+	{ "a<meta>x</meta>b",						"ab" },
+	{ "a<META >x</ meta>b",						"ab" },
+	{ "a<iframe>x</iframe>b",					"ab" },
+	{ "a<iframe src=\"http://example.com/\">x</iframe>b",		"ab" },
+	{ "a<IFRAME SRC='x' WIDTH=1>x</IfRaMe >b",			"ab" },
+	{ "a< iframe\n\tsrc=\"x\">x</\niframe>b",			"ab" },
+	{ "<img src=\"a.png\" onload=\"evil()\">",			"<img src=\"a.png\">" },
+	{ "<img src=\"a.png\" onload='evil(\"x\")'>",			"<img src=\"a.png\">" },
+	{ "<img src=\"a.png\"\n\tONLOAD=\"evil()\"/>",			"<img src=\"a.png\"/>" },
+	{ "<img src=\"a.png\" OnLoad='evil()' alt=\"\">",		"<img src=\"a.png\" alt=\"\">" },
+	{ "<img src=\"a.png\" onload=\"\">",				"<img src=\"a.png\" onload=\"\">" },	/* empty value */
+	{ "<img src=\"a.png\" onload=evil()>",				"<img src=\"a.png\" onload=evil()>" },	/* unquoted value */
+	{ "<img src=\"a.png\" onload=\"evil()",				"<img src=\"a.png\" onload=\"evil()" },	/* unterminated */
+	{ "text onload=\"x\" text",					"text text" },
+	{ "a<wbr>b<WBR/>c< wbr >d</wbr>e",				"abcde" },
+	{ "<body>text</body>",						"text" },
+	{ "<BODY class=\"x\">text</BODY >",				"text" },
+	{ "<body onload=\"evil()\">text</body>",			"text" },
+	{ "<body onload=\"evil()\"><script>x</script>text</body>",	"text" }
+};
+
+int
+main (int argc, char **argv)
+{
+	guint	i, failed = 0;
+	gchar	*result;
+
+	for (i = 0; i < G_N_ELEMENTS (cases); i++) {
+		const stripCase *c = &cases[i];
+
+		result = xhtml_strip_dhtml_and_unsupported_tags (c->html);
+		if (!result || !g_str_equal (result, c->expected)) {
+			g_printerr ("\"%s\" stripped to \"%s\", expected \"%s\"\n",
+			            c->html, result, c->expected);
+			failed++;
+		}
+		g_free (result);
+	}
+
+	if (xhtml_strip_dhtml_and_unsupported_tags (NULL)) {
+		g_printerr ("NULL not stripped to NULL\n");
+		failed++;
+	}
+
+	if (failed) {
+		g_printerr ("%u of %u strip checks failed\n", failed, (guint)G_N_ELEMENTS (cases) + 1);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}